@@ -4,12 +4,14 @@
 #include "EventEMin/convolution.h"
 #include "EventEMin/data_stats.h"
 #include "EventEMin/dispersion.h"
+#include "EventEMin/estimate_sink.h"
 #include "EventEMin/event.h"
 #include "EventEMin/gauss_kernel.h"
 #include "EventEMin/image.h"
 #include "EventEMin/model.h"
 #include "EventEMin/optimiser.h"
 #include "EventEMin/test.h"
+#include "EventEMin/thread_pool.h"
 #include "EventEMin/types_def.h"
 
 #endif  // EVENT_EMIN_H
@@ -64,7 +64,10 @@ transform(const Container& c1, const Container& c2, Functor&& op)
   return container;
 }
 
-template <typename T, int N, typename U = T>
+/* grid of the convolutions of the values T splatted into it, whose cells
+   decay with the time U since their previous splat unless Decay is false, in
+   which case the grid keeps no times */
+template <typename T, int N, typename U = T, bool Decay = true>
 class Convolution
 {
  public:
@@ -81,6 +84,9 @@ class Convolution
   Tensor<T, N> val_;
   Tensor<U, N> ts_;
 
+  // cells [touchedBegin_, touchedEnd_) convolved since the last reset
+  Array<Index, N> touchedBegin_, touchedEnd_;
+
  public:
   Convolution(const Array<Index, N>& dim, const Array<Index, N>& kdim,
               const U& lambda = U(2.0 * M_PI), const U& tsRef = U(0.0))
@@ -89,11 +95,21 @@ class Convolution
         offset_(std::move(transform(kdim_, OffsetOp<Index>()))),
         lambda_(lambda),
         val_(std::move(transform(dim_, kdim_, OffsetOp<Index>()))),
-        ts_(dim_)
+        ts_(Decay ? dim_ : Array<Index, N>())
   {
     reset(tsRef);
   }
 
+  const Array<Index, N>&
+  dim(void) const
+  {
+    return dim_;
+  }
+  const Array<Index, N>&
+  kdim(void) const
+  {
+    return kdim_;
+  }
   U
   lambda(void) const
   {
@@ -125,13 +141,74 @@ class Convolution
        const Kernel& kernel)
   {
     // found no better way of doing this using Tensor
-    const U expts = std::exp(-lambda_ * (ts - ts_(ind)));
+    U expts = U(1.0);
+    if constexpr (Decay)
+    {
+      expts = std::exp(-lambda_ * (ts - ts_(ind)));
+      ts_(ind) = ts;
+    }
+    const Array<Index, N> dim(
+        std::move(transform(ind, kdim_, AddOffsetOp<Index>())));
+    Array<Index, N> indTemp;
+    iterate(expts, val, kernel, 0, dim, ind, dim, indTemp);
+    Array<Index, N> end;
+    for (int d = 0; d < N; ++d)
+    {
+      end[d] = ind[d] + 1;
+    }
+    touch(ind, end);
+  }
+
+  /* conv restricted to the values [colBegin, colEnd) along the last
+     dimension, given the previous time tsPrev of the cell ind, which is left
+     to the caller to update, as are the touched cells: bands of values along
+     the last dimension are independent of each other, so that they can be
+     convolved in parallel, each value going through the same updates as
+     with conv */
+  void
+  convColumns(const Array<Index, N>& ind, const U& ts, const U& tsPrev,
+              const U& lambda, const T& val, const Kernel& kernel,
+              const Index colBegin, const Index colEnd)
+  {
     const Array<Index, N> dim(
         std::move(transform(ind, kdim_, AddOffsetOp<Index>())));
+    Array<Index, N> begin(ind), end(dim);
+    begin[N - 1] = std::max(ind[N - 1], colBegin);
+    end[N - 1] = std::min(dim[N - 1], colEnd);
+    if (end[N - 1] <= begin[N - 1])
+    {
+      return;
+    }
+    U expts = U(1.0);
+    if constexpr (Decay)
+    {
+      expts = std::exp(-lambda * (ts - tsPrev));
+    }
     Array<Index, N> indTemp;
-    iterate(expts, val, kernel, 0, dim, ind, indTemp);
+    iterate(expts, val, kernel, 0, dim, begin, end, indTemp);
+  }
+  // convColumns of the grids without decay
+  void
+  convColumns(const Array<Index, N>& ind, const T& val, const Kernel& kernel,
+              const Index colBegin, const Index colEnd)
+  {
+    convColumns(ind, U(0.0), U(0.0), U(0.0), val, kernel, colBegin, colEnd);
+  }
+  void
+  setTs(const Array<Index, N>& ind, const U& ts)
+  {
     ts_(ind) = ts;
   }
+  // marks the cells [begin, end) as convolved
+  void
+  touch(const Array<Index, N>& begin, const Array<Index, N>& end)
+  {
+    for (int d = 0; d < N; ++d)
+    {
+      touchedBegin_[d] = std::min(touchedBegin_[d], begin[d]);
+      touchedEnd_[d] = std::max(touchedEnd_[d], end[d]);
+    }
+  }
 
   // found no efficient way of implementing update() using Tensor
 
@@ -139,35 +216,65 @@ class Convolution
   reset(const U& ti = U(0.0))
   {
     val_.setZero();
-    ts_.setConstant(ti);
+    if constexpr (Decay)
+    {
+      ts_.setConstant(ti);
+    }
+    touchedBegin_ = dim_;
+    touchedEnd_.fill(0);
+  }
+  // same as reset, given that only the convolved cells changed since
+  void
+  resetTouched(const U& ti = U(0.0))
+  {
+    Array<Index, N> extent;
+    for (int d = 0; d < N; ++d)
+    {
+      if (touchedEnd_[d] <= touchedBegin_[d])
+      {
+        return;
+      }
+      extent[d] = touchedEnd_[d] - touchedBegin_[d];
+    }
+    if constexpr (Decay)
+    {
+      ts_.slice(touchedBegin_, extent).setConstant(ti);
+    }
+    val_.slice(touchedBegin_,
+               std::move(transform(extent, kdim_, OffsetOp<Index>())))
+        .setZero();
+    touchedBegin_ = dim_;
+    touchedEnd_.fill(0);
   }
 
  protected:
+  // values [iind, iend) of the splat of a cell whose kernel ends at dim
   void
   iterate(const U& expts, const T& val, const Tensor<U, N>& kernel, const int d,
           const Array<Index, N>& dim, const Array<Index, N>& iind,
-          Array<Index, N>& ind)
+          const Array<Index, N>& iend, Array<Index, N>& ind)
   {
     if (d >= N)
     {
       const Array<Index, N> kind(
           std::move(transform(dim, ind, SubOffsetOp<Index>())));
-      val_(ind) *= expts;
+      if constexpr (Decay)
+      {
+        val_(ind) *= expts;
+      }
       val_(ind) += val * kernel(kind);
       return;
     }
 
-    for (ind[d] = iind[d]; ind[d] < dim[d]; ++ind[d])
+    for (ind[d] = iind[d]; ind[d] < iend[d]; ++ind[d])
     {
-      iterate(expts, val, kernel, d + 1, dim, iind, ind);
+      iterate(expts, val, kernel, d + 1, dim, iind, iend, ind);
     }
   }
-
- private:
 };
 
-template <typename T, typename U>
-class Convolution<T, 2, U>
+template <typename T, typename U, bool Decay>
+class Convolution<T, 2, U, Decay>
 {
  public:
   typedef Matrix<U> Kernel;
@@ -183,6 +290,9 @@ class Convolution<T, 2, U>
   Matrix<T> val_;
   Matrix<U> ts_;
 
+  // cells [touchedBegin_, touchedEnd_) convolved since the last reset
+  Array<Index, 2> touchedBegin_, touchedEnd_;
+
  public:
   Convolution(const Array<Index, 2>& dim, const Array<Index, 2>& kdim,
               const U& lambda = U(2.0 * M_PI), const U& tsRef = U(0.0))
@@ -191,11 +301,21 @@ class Convolution<T, 2, U>
         offset_(std::move(transform(kdim_, OffsetOp<Index>()))),
         lambda_(lambda),
         val_(dim_[0] + kdim_[0] - 1, dim_[1] + kdim_[1] - 1),
-        ts_(dim_[0], dim_[1])
+        ts_(Decay ? dim_[0] : 0, Decay ? dim_[1] : 0)
   {
     reset(tsRef);
   }
 
+  const Array<Index, 2>&
+  dim(void) const
+  {
+    return dim_;
+  }
+  const Array<Index, 2>&
+  kdim(void) const
+  {
+    return kdim_;
+  }
   int
   width(void) const
   {
@@ -245,12 +365,70 @@ class Convolution<T, 2, U>
     assert(kernel.rows() <= kdim_[0]);
     assert(kernel.cols() <= kdim_[1]);
 
-    val_.block(ind[0], ind[1], kernel.rows(), kernel.cols()) *=
-        std::exp(-lambda * (ts - ts_(ind[0], ind[1])));
-    val_.block(ind[0], ind[1], kernel.rows(), kernel.cols()) +=
-        val * kernel.reverse();
+    if constexpr (Decay)
+    {
+      convColumns(ind, ts, ts_(ind[0], ind[1]), lambda, val, kernel, 0,
+                  val_.cols());
+      ts_(ind[0], ind[1]) = ts;
+    }
+    else
+    {
+      convColumns(ind, val, kernel, 0, val_.cols());
+    }
+    touch(ind, {ind[0] + 1, ind[1] + 1});
+  }
+
+  /* conv restricted to the value columns [colBegin, colEnd), given the
+     previous time tsPrev of the cell ind, which is left to the caller to
+     update, as are the touched cells: bands of value columns are
+     independent of each other, so that they can be convolved in parallel,
+     each value going through the same updates as with conv */
+  void
+  convColumns(const Array<Index, 2>& ind, const U& ts, const U& tsPrev,
+              const U& lambda, const T& val, const Kernel& kernel,
+              const Index colBegin, const Index colEnd)
+  {
+    assert(0 <= ind[0] && ind[0] < width());
+    assert(0 <= ind[1] && ind[1] < height());
+
+    const Index begin = std::max(ind[1], colBegin),
+                end = std::min(ind[1] + kernel.cols(), colEnd);
+    if (end <= begin)
+    {
+      return;
+    }
+    if constexpr (Decay)
+    {
+      val_.block(ind[0], begin, kernel.rows(), end - begin) *=
+          std::exp(-lambda * (ts - tsPrev));
+    }
+    val_.block(ind[0], begin, kernel.rows(), end - begin) +=
+        val * kernel.reverse().middleCols(begin - ind[1], end - begin);
+  }
+  // convColumns of the grids without decay
+  void
+  convColumns(const Array<Index, 2>& ind, const T& val, const Kernel& kernel,
+              const Index colBegin, const Index colEnd)
+  {
+    convColumns(ind, U(0.0), U(0.0), U(0.0), val, kernel, colBegin, colEnd);
+  }
+  void
+  setTs(const Array<Index, 2>& ind, const U& ts)
+  {
+    assert(0 <= ind[0] && ind[0] < width());
+    assert(0 <= ind[1] && ind[1] < height());
     ts_(ind[0], ind[1]) = ts;
   }
+  // marks the cells [begin, end) as convolved
+  void
+  touch(const Array<Index, 2>& begin, const Array<Index, 2>& end)
+  {
+    for (int d = 0; d < 2; ++d)
+    {
+      touchedBegin_[d] = std::min(touchedBegin_[d], begin[d]);
+      touchedEnd_[d] = std::max(touchedEnd_[d], end[d]);
+    }
+  }
 
   void
   conv(const Array<Index, 2>& ind, const U& ts, const T& val,
@@ -262,6 +440,10 @@ class Convolution<T, 2, U>
   void
   update(const U& ts)
   {
+    if constexpr (!Decay)
+    {
+      return;
+    }
     const Matrix<U> tsimg((-lambda() * (ts - ts_.array())).exp());
 
     // core image block
@@ -318,11 +500,39 @@ class Convolution<T, 2, U>
   {
     val_.setZero();
     resetTime(ti);
+    touchedBegin_ = dim_;
+    touchedEnd_.fill(0);
+  }
+  // same as reset, given that only the convolved cells changed since
+  void
+  resetTouched(const U& ti = U(0.0))
+  {
+    const Index rows = touchedEnd_[0] - touchedBegin_[0],
+                cols = touchedEnd_[1] - touchedBegin_[1];
+    if (0 < rows && 0 < cols)
+    {
+      if constexpr (Decay)
+      {
+        ts_.block(touchedBegin_[0], touchedBegin_[1], rows, cols)
+            .setConstant(ti);
+      }
+      val_.block(touchedBegin_[0], touchedBegin_[1], rows + kdim_[0] - 1,
+                 cols + kdim_[1] - 1)
+          .setZero();
+    }
+    touchedBegin_ = dim_;
+    touchedEnd_.fill(0);
   }
+  // the whole grid is then touched
   void
   resetTime(const U& ti = U(0.0))
   {
-    ts_.setConstant(ti);
+    if constexpr (Decay)
+    {
+      ts_.setConstant(ti);
+    }
+    touchedBegin_.fill(0);
+    touchedEnd_ = dim_;
   }
 };
 }  // namespace EventEMin
@@ -1,36 +1,469 @@
 #ifndef EVENT_EMIN_DATA_STATS_H
 #define EVENT_EMIN_DATA_STATS_H
 
+#include <Eigen/Jacobi>
+#include <Eigen/LU>
 #include <Eigen/SVD>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <utility>
 
 #include "EventEMin/types_def.h"
+#include "EventEMin/utilities.h"
 
 namespace EventEMin
 {
+/* eigenvalues of a symmetric 2x2 or 3x3 matrix, in decreasing order: the
+   small 2x2 one is the determinant over the large one, which does not cancel
+   as their difference with the mean does; the 3x3 ones are found by the
+   trigonometric solution of the characteristic polynomial on the values, the
+   derivatives of AutoDiff scalars being carried by a Newton step on the
+   polynomial of a that leaves the values as they are */
+template <typename U>
+void
+symmetricEigenvalues(const Matrix<U, 2, 2>& a, Vector<U, 2>& l)
+{
+  using std::sqrt;
+
+  const U m((a(0, 0) + a(1, 1)) / 2), d((a(0, 0) - a(1, 1)) / 2);
+  const U r(sqrt(d * d + a(0, 1) * a(0, 1)));
+  const U l0(m + r);
+  if (scalarValue(l0) > 0)
+  {
+    l << l0, (a(0, 0) * a(1, 1) - a(0, 1) * a(0, 1)) / l0;
+  }
+  else
+  {
+    l << l0, m - r;
+  }
+}
+template <typename U>
+void
+symmetricEigenvalues(const Matrix<U, 3, 3>& a, Vector<U, 3>& l)
+{
+  typedef typename std::decay<decltype(scalarValue(U()))>::type T;
+
+  // the values in double at least, the roots of the trigonometric solution
+  // losing half of the digits on nearly repeated eigenvalues
+  typedef decltype(T() * 1.0) TV;
+  Matrix<TV, 3, 3> av;
+  for (int j = 0; j < 3; ++j)
+  {
+    for (int i = 0; i < 3; ++i)
+    {
+      av(i, j) = scalarValue(a(i, j));
+    }
+  }
+
+  const TV q = av.trace() / 3;
+  const TV p1 = av(0, 1) * av(0, 1) + av(0, 2) * av(0, 2) + av(1, 2) * av(1, 2);
+  const TV p2 = (av.diagonal().array() - q).square().sum() + 2 * p1;
+  Vector<T, 3> lv;
+  if (p2 <= TV(0.0))
+  {
+    lv.setConstant(T(q));
+  }
+  else
+  {
+    const TV p = std::sqrt(p2 / 6);
+    const TV r =
+        ((av - q * Matrix<TV, 3, 3>::Identity()) / p).determinant() / 2;
+    const TV phi = std::acos(std::min(TV(1.0), std::max(TV(-1.0), r))) / 3;
+    const TV l0 = q + 2 * p * std::cos(phi);
+    const TV l2 = q + 2 * p * std::cos(phi + TV(2.0 * M_PI / 3.0));
+    lv << T(l0), T(3 * q - l0 - l2), T(l2);
+  }
+
+  // characteristic polynomial l^3 - c2 l^2 + c1 l - c0
+  const U c2(a.trace());
+  const U c1(a(0, 0) * a(1, 1) + a(0, 0) * a(2, 2) + a(1, 1) * a(2, 2) -
+             a(0, 1) * a(0, 1) - a(0, 2) * a(0, 2) - a(1, 2) * a(1, 2));
+  const U c0(a.determinant());
+  const T c2v = scalarValue(c2), c1v = scalarValue(c1),
+          c0v = scalarValue(c0);
+  const T tol =
+      std::sqrt(std::numeric_limits<T>::epsilon()) * lv.squaredNorm();
+  for (int i = 0; i < 3; ++i)
+  {
+    // derivatives by implicit differentiation of the polynomial, skipped on
+    // (nearly) repeated eigenvalues, where its derivative vanishes
+    const T dp = (3 * lv(i) - 2 * c2v) * lv(i) + c1v;
+    if (std::abs(dp) > tol)
+    {
+      const T pv = ((lv(i) - c2v) * lv(i) + c1v) * lv(i) - c0v;
+      l(i) = lv(i) - ((((lv(i) - c2) * lv(i) + c1) * lv(i) - c0) - pv) / dp;
+    }
+    else
+    {
+      l(i) = U(lv(i));
+    }
+  }
+}
+
+/* closed-form whitening w = c^(-1/2) of a symmetric positive definite 2x2 or
+   3x3 matrix c, as a polynomial in c whose coefficients are the elementary
+   symmetric functions i1, i2, (i3) of the square roots of its eigenvalues,
+   so that no eigenvectors are needed */
+template <typename U>
+void
+whiteningPolynomial(const Matrix<U, 2, 2>& c, const U& i1, const U& i2,
+                    Matrix<U, 2, 2>& w)
+{
+  // c^(1/2) = (c + i2 I) / i1, and c^(-1/2) = (i1 I - c^(1/2)) / i2
+  w = -c;
+  w.diagonal().array() += i1 * i1 - i2;
+  w /= i1 * i2;
+}
+template <typename U>
+void
+whiteningPolynomial(const Matrix<U, 3, 3>& c, const U& i1, const U& i2,
+                    const U& i3, Matrix<U, 3, 3>& w)
+{
+  // c^(1/2) = (-c^2 + (i1^2 - i2) c + i1 i3 I) / (i1 i2 - i3), and
+  // c^(-1/2) = (c - i1 c^(1/2) + i2 I) / i3
+  const U k(i1 / (i1 * i2 - i3));
+  w.noalias() = k * c * c;
+  w += (1 - k * (i1 * i1 - i2)) * c;
+  w.diagonal().array() += i2 - k * i1 * i3;
+  w /= i3;
+}
+
+/* square roots of the eigenvalues, in decreasing order, and whitening of c;
+   the eigenvalues are kept above the floor of computeWhitening, which
+   rounding may take them under */
+constexpr double whiteningFloor = 1.0e-8;
+
+template <typename U>
+void
+closedFormWhitening(const Matrix<U, 2, 2>& c, Vector<U, 2>& s,
+                    Matrix<U, 2, 2>& w)
+{
+  symmetricEigenvalues(c, s);
+  s = s.cwiseMax(U(whiteningFloor)).cwiseSqrt();
+  whiteningPolynomial(c, U(s(0) + s(1)), U(s(0) * s(1)), w);
+}
+template <typename U>
+void
+closedFormWhitening(const Matrix<U, 3, 3>& c, Vector<U, 3>& s,
+                    Matrix<U, 3, 3>& w)
+{
+  symmetricEigenvalues(c, s);
+  s = s.cwiseMax(U(whiteningFloor)).cwiseSqrt();
+  whiteningPolynomial(c, U(s.sum()),
+                      U(s(0) * s(1) + s(0) * s(2) + s(1) * s(2)), U(s.prod()),
+                      w);
+}
+template <typename U>
+void
+closedFormWhitening(const Matrix<U, 2, 2>& c, Matrix<U, 2, 2>& w)
+{
+  using std::sqrt;
+
+  // s0 s1 and s0 + s1 from the determinant and the trace, with no square root
+  // of the discriminant, which is not differentiable on repeated eigenvalues
+  const U i2(sqrt(c.determinant()));
+  whiteningPolynomial(c, U(sqrt(c.trace() + 2 * i2)), i2, w);
+}
+template <typename U>
+void
+closedFormWhitening(const Matrix<U, 3, 3>& c, Matrix<U, 3, 3>& w)
+{
+  Vector<U, 3> s;
+  closedFormWhitening(c, s, w);
+}
+
+/* scalar of the closed-form whitenings of U: double at least, with the
+   derivatives of U, since the polynomials of the whitenings lose the digits
+   of the small eigenvalues of nearly singular covariances, and the floor of
+   1e-8 is lost on the covariances in float */
+template <typename U>
+struct WhiteningScalar
+{
+  typedef decltype(U() * 1.0) type;
+
+  static type
+  promote(const U& x)
+  {
+    return x;
+  }
+  static U
+  demote(const type& x)
+  {
+    return static_cast<U>(x);
+  }
+};
+template <typename DerType>
+struct WhiteningScalar<Eigen::AutoDiffScalar<DerType> >
+{
+  typedef Eigen::AutoDiffScalar<DerType> U;
+  typedef typename U::Scalar S;
+  typedef Eigen::AutoDiffScalar<
+      Vector<decltype(S() * 1.0), DerType::RowsAtCompileTime> >
+      type;
+
+  static type
+  promote(const U& x)
+  {
+    return type(x.value(),
+                x.derivatives().template cast<typename type::Scalar>());
+  }
+  static U
+  demote(const type& x)
+  {
+    return U(static_cast<S>(x.value()), x.derivatives().template cast<S>());
+  }
+};
+
+/* cov + 1e-8 I in the scalar of the closed forms, shifted further if
+   rounding took its smallest eigenvalue under the floor, as on nearly
+   singular covariances, so that the square roots of the eigenvalues match
+   the matrix they whiten, and the values of its eigenvalues */
+template <int n, typename Derived, typename TV>
+Matrix<typename WhiteningScalar<typename Derived::Scalar>::type, n, n>
+promoteCovariance(const MatrixBase<Derived>& cov, Vector<TV, n>& l)
+{
+  typedef WhiteningScalar<typename Derived::Scalar> WS;
+  Matrix<typename WS::type, n, n> c;
+  Matrix<TV, n, n> cv;
+  for (int j = 0; j < n; ++j)
+  {
+    for (int i = 0; i < n; ++i)
+    {
+      c(i, j) = WS::promote(cov(i, j));
+      cv(i, j) = scalarValue(c(i, j));
+    }
+  }
+  symmetricEigenvalues(cv, l);
+  const TV shift = whiteningFloor + std::max(TV(0.0), TV(-l(n - 1)));
+  c.diagonal().array() += shift;
+  l.array() += shift;
+  return c;
+}
+
+/* largest condition number of the n x n covariances whitened in closed form:
+   the error of the 2x2 polynomial grows with the condition number, as that
+   of the eigendecomposition does, while the error of the 3x3 one grows with
+   its square, so that past 1e2 it is behind the eigendecomposition */
+template <int n>
+constexpr double whiteningMaxCondition = n == 2 ? 1.0e6 : 1.0e2;
+
+/* eigenvalues, in decreasing order, and eigenvectors of a symmetric matrix
+   by cyclic Jacobi rotations, which keep the relative accuracy of the small
+   eigenvalues of positive definite matrices; every rotation is skipped once
+   its entry is negligible w.r.t. its diagonal entries */
+template <typename T, int n>
+void
+symmetricEigenvectors(Matrix<T, n, n> a, Vector<T, n>& l, Matrix<T, n, n>& v)
+{
+  using std::abs;
+  using std::sqrt;
+
+  constexpr int maxSweeps = 16;
+  const T eps = std::numeric_limits<T>::epsilon();
+  v.setIdentity();
+  for (int sweep = 0; sweep < maxSweeps; ++sweep)
+  {
+    bool rotated = false;
+    for (int p = 0; p < n - 1; ++p)
+    {
+      for (int q = p + 1; q < n; ++q)
+      {
+        if (abs(a(p, q)) <= eps * sqrt(abs(a(p, p) * a(q, q))))
+        {
+          continue;
+        }
+        Eigen::JacobiRotation<T> j;
+        j.makeJacobi(a, p, q);
+        a.applyOnTheLeft(p, q, j.adjoint());
+        a.applyOnTheRight(p, q, j);
+        v.applyOnTheRight(p, q, j);
+        rotated = true;
+      }
+    }
+    if (!rotated)
+    {
+      break;
+    }
+  }
+
+  l = a.diagonal();
+  for (int i = 0; i < n - 1; ++i)
+  {
+    int iMax;
+    l.tail(n - i).maxCoeff(&iMax);
+    if (0 < iMax)
+    {
+      std::swap(l(i), l(i + iMax));
+      v.col(i).swap(v.col(i + iMax));
+    }
+  }
+}
+
+/* square roots of the eigenvalues, in decreasing order, and whitening of c
+   from its eigendecomposition, with the eigenvectors in v; for AutoDiff
+   scalars, the decomposition is that of the values, the derivatives being
+   those of the matrix function, dw = v (F o v^T dc v) v^T with
+   F_ij = -1 / (s_i s_j (s_i + s_j)) */
+template <typename T, int n>
+void
+eigenWhitening(const Matrix<T, n, n>& c, Vector<T, n>& s, Matrix<T, n, n>& w,
+               Matrix<T, n, n>& v)
+{
+  symmetricEigenvectors(c, s, v);
+  s = s.cwiseMax(T(whiteningFloor)).cwiseSqrt();
+  w.noalias() = v * s.cwiseInverse().asDiagonal() * v.transpose();
+}
+template <typename T, int n>
+void
+eigenWhitening(const Matrix<T, n, n>& c, Vector<T, n>& s, Matrix<T, n, n>& w)
+{
+  Matrix<T, n, n> v;
+  eigenWhitening(c, s, w, v);
+}
+template <typename DerType, int n>
+void
+eigenWhitening(const Matrix<Eigen::AutoDiffScalar<DerType>, n, n>& c,
+               Vector<Eigen::AutoDiffScalar<DerType>, n>& s,
+               Matrix<Eigen::AutoDiffScalar<DerType>, n, n>& w)
+{
+  typedef Eigen::AutoDiffScalar<DerType> U;
+  typedef typename U::Scalar T;
+  typedef typename Eigen::internal::remove_all<DerType>::type D;
+
+  Matrix<T, n, n> cv;
+  for (int j = 0; j < n; ++j)
+  {
+    for (int i = 0; i < n; ++i)
+    {
+      cv(i, j) = c(i, j).value();
+    }
+  }
+  Vector<T, n> sv;
+  Matrix<T, n, n> wv, v;
+  eigenWhitening(cv, sv, wv, v);
+
+  Matrix<T, n, n> f;
+  for (int j = 0; j < n; ++j)
+  {
+    for (int i = 0; i < n; ++i)
+    {
+      f(i, j) = -1.0 / (sv(i) * sv(j) * (sv(i) + sv(j)));
+    }
+  }
+
+  const Eigen::Index nVars = c(0, 0).derivatives().size();
+  for (int j = 0; j < n; ++j)
+  {
+    s(j) = U(sv(j), D::Zero(nVars));
+    for (int i = 0; i < n; ++i)
+    {
+      w(i, j) = U(wv(i, j), D::Zero(nVars));
+    }
+  }
+  Matrix<T, n, n> dc, e, dw;
+  for (Eigen::Index k = 0; k < nVars; ++k)
+  {
+    for (int j = 0; j < n; ++j)
+    {
+      for (int i = 0; i < n; ++i)
+      {
+        dc(i, j) = c(i, j).derivatives()(k);
+      }
+    }
+    e.noalias() = v.transpose() * dc * v;
+    dw.noalias() = v * f.cwiseProduct(e) * v.transpose();
+    for (int j = 0; j < n; ++j)
+    {
+      s(j).derivatives()(k) = e(j, j) / (2.0 * sv(j));
+      for (int i = 0; i < n; ++i)
+      {
+        w(i, j).derivatives()(k) = dw(i, j);
+      }
+    }
+  }
+}
+
+/* whitening of the covariance cov, w = (cov + 1e-8 I)^(-1/2), and the square
+   roots of the eigenvalues of cov + 1e-8 I; closed form in 2 and 3
+   dimensions, from the eigendecomposition in double if cov is too
+   ill-conditioned for it, and from the SVD otherwise */
 template <typename Derived1, typename Derived2>
 void
 computeWhitening(const MatrixBase<Derived1>& cov, MatrixBase<Derived2>& w)
 {
-  const Eigen::JacobiSVD<Derived1> svd(cov, Eigen::ComputeFullU);
-  w.noalias() = svd.matrixU() *
-                (svd.singularValues().array() + 1.0e-8)
-                    .sqrt()
-                    .inverse()
-                    .matrix()
-                    .asDiagonal() *
-                svd.matrixU().transpose();
+  typedef typename Derived1::Scalar U;
+  constexpr int n = Derived1::RowsAtCompileTime;
+
+  if constexpr (n == 2 || n == 3)
+  {
+    typedef WhiteningScalar<U> WS;
+    typedef typename std::decay<decltype(scalarValue(
+        std::declval<typename WS::type>()))>::type TV;
+    Vector<TV, n> l;
+    const Matrix<typename WS::type, n, n> c(promoteCovariance<n>(cov, l));
+    Matrix<typename WS::type, n, n> wc;
+    if (l(0) <= whiteningMaxCondition<n> * l(n - 1))
+    {
+      closedFormWhitening(c, wc);
+    }
+    else
+    {
+      Vector<typename WS::type, n> s;
+      eigenWhitening(c, s, wc);
+    }
+    w = wc.unaryExpr(&WS::demote);
+  }
+  else
+  {
+    const Eigen::JacobiSVD<Derived1> svd(cov, Eigen::ComputeFullU);
+    w.noalias() = svd.matrixU() *
+                  (svd.singularValues().array() + 1.0e-8)
+                      .sqrt()
+                      .inverse()
+                      .matrix()
+                      .asDiagonal() *
+                  svd.matrixU().transpose();
+  }
 }
 template <typename Derived1, typename Derived2, typename Derived3>
 void
 computeWhitening(const MatrixBase<Derived1>& cov, MatrixBase<Derived2>& w,
                  MatrixBase<Derived3>& sValues)
 {
-  const Eigen::JacobiSVD<Derived1> svd(cov, Eigen::ComputeFullU);
-  sValues = (svd.singularValues().array() + 1.0e-8).sqrt();
-  w.noalias() = svd.matrixU() *
-                sValues.array().inverse().matrix().asDiagonal() *
-                svd.matrixU().transpose();
+  typedef typename Derived1::Scalar U;
+  constexpr int n = Derived1::RowsAtCompileTime;
+
+  if constexpr (n == 2 || n == 3)
+  {
+    typedef WhiteningScalar<U> WS;
+    typedef typename std::decay<decltype(scalarValue(
+        std::declval<typename WS::type>()))>::type TV;
+    Vector<TV, n> l;
+    const Matrix<typename WS::type, n, n> c(promoteCovariance<n>(cov, l));
+    Matrix<typename WS::type, n, n> wc;
+    Vector<typename WS::type, n> s;
+    if (l(0) <= whiteningMaxCondition<n> * l(n - 1))
+    {
+      closedFormWhitening(c, s, wc);
+    }
+    else
+    {
+      eigenWhitening(c, s, wc);
+    }
+    w = wc.unaryExpr(&WS::demote);
+    sValues = s.unaryExpr(&WS::demote);
+  }
+  else
+  {
+    const Eigen::JacobiSVD<Derived1> svd(cov, Eigen::ComputeFullU);
+    sValues = (svd.singularValues().array() + 1.0e-8).sqrt();
+    w.noalias() = svd.matrixU() *
+                  sValues.array().inverse().matrix().asDiagonal() *
+                  svd.matrixU().transpose();
+  }
 }
 template <typename Derived1, typename Derived2, typename Derived3>
 void
@@ -108,7 +541,10 @@ class DataStats
   computeCov(void)
   {
     assert(centred().cols() > 1);
-    cov_.noalias() = centred() * centred().transpose() / (centred().cols() - 1);
+    // scaled in place, since the scaled product would be evaluated into a
+    // temporary
+    cov_.noalias() = centred() * centred().transpose();
+    cov_ /= T(centred().cols() - 1);
   }
   void
   computeCov(const Ref<const Vector<T> >& weights, const T& weightsSum)
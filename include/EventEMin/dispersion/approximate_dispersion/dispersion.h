@@ -1,6 +1,10 @@
 #ifndef EVENT_EMIN_APPROXIMATE_DISPERSION_IMPL_H
 #define EVENT_EMIN_APPROXIMATE_DISPERSION_IMPL_H
 
+#include <algorithm>
+#include <optional>
+#include <vector>
+
 #include "EventEMin/convolution.h"
 #include "EventEMin/dispersion/dispersion.h"
 #include "EventEMin/event/transform.h"
@@ -27,8 +31,97 @@ class Dispersion : public DispersionBase<Dispersion<Derived> >
   typedef typename Convolution<T, NDims, T>::Kernel Kernel;
 
  private:
+  /* grid of the convolutions of U, with decay or not, built once for the
+     points and reset by clearing the cells of the previous evaluation only */
+  template <typename U>
+  struct ConvolutionBuffers
+  {
+    std::optional<Convolution<U, NDims, T> > conv;
+    std::optional<Convolution<U, NDims, T, false> > convNoDecay;
+    T tsRef;
+
+    template <bool Decay>
+    std::optional<Convolution<U, NDims, T, Decay> >&
+    get(void)
+    {
+      if constexpr (Decay)
+      {
+        return conv;
+      }
+      else
+      {
+        return convNoDecay;
+      }
+    }
+  };
+
+  /* cells of the bilinear splat of every point, and its weights at the two
+     cells of every dimension, computed once per evaluation for both the
+     splat and the interpolation */
+  template <typename U>
+  struct CornerBuffers
+  {
+    std::vector<Array<Index, NDims> > lcMin, lcMax;
+    // weight of point k at the cell lcMin[k][d] + i at (2 * d + i, k)
+    Matrix<U> weights;
+    // partials of the interpolation
+    std::vector<U> fPart;
+
+    void
+    resize(const int nPoints)
+    {
+      lcMin.resize(nPoints);
+      lcMax.resize(nPoints);
+      weights.resize(2 * NDims, nPoints);
+    }
+  };
+
+  // bands of value columns of the splat of the points, see add
+  struct SplatBuffers
+  {
+    // band b at the value columns [colStart[b], colStart[b + 1]), the
+    // columns running along the last dimension
+    std::vector<Index> colStart;
+    // first and last bands reached by every point, and points per band of
+    // every block of points
+    std::vector<int> pointBands, blockCount;
+    // points of every band in order, band b at
+    // [bandPoints[bandStart[b]], bandPoints[bandStart[b + 1]])
+    std::vector<int> bandStart, bandPoints;
+    // times of the cells before every band, in the order of the grid, and
+    // cells convolved by it
+    std::vector<Vector<T> > halo;
+    std::vector<Array<Index, NDims> > touchedBegin, touchedEnd;
+
+    void
+    resizeBands(const int nBands)
+    {
+      colStart.resize(nBands + 1);
+      bandStart.resize(nBands + 1);
+      halo.resize(nBands);
+      touchedBegin.resize(nBands);
+      touchedEnd.resize(nBands);
+    }
+  };
+
+  /* points per block of the corners, of the band search and of the
+     interpolation, and points and value columns per band at least, for the
+     splat to run in several bands */
+  static constexpr int pointBlockSize = 4096;
+  static constexpr int minBandPoints = 2048;
+  static constexpr int minBandCols = 16;
+
   const T dimScaleMax_;
   Array<Index, NDims> cMin_, cMax_, dim_;
+  // decay of the points at the end of their window, see preparePoints
+  Vector<T> decay_;
+
+  // the evaluations are not reentrant: they share these grids and buffers
+  mutable Workspaces<ConvolutionBuffers, T, NVars> convolutions_;
+  mutable Workspaces<CornerBuffers, T, NVars> corners_;
+  mutable SplatBuffers splatBuffers_;
+  // gradient of the interpolated sum w.r.t. the points, see fdf
+  mutable RowMajorMatrix<T> gradient_;
 
  protected:
   Array<Index, NDims> kdim_;
@@ -107,19 +200,89 @@ class Dispersion : public DispersionBase<Dispersion<Derived> >
   {
     return lambda_;
   }
+  bool
+  decays(void) const
+  {
+    return lambda() != T(0.0);
+  }
+  T
+  decay(const int k) const
+  {
+    assert(0 <= k && k < decay_.size());
+    return decay_(k);
+  }
   const Kernel&
   kernel(void) const
   {
     return kernel_;
   }
 
+  /* the grids with and without decay are separate kernels, so that those
+     without decay, for lambda = 0, skip the times and their exponentials */
   template <typename U>
   U
   compute(const Matrix<U>& c) const
   {
-    Convolution<U, NDims, T> conv(dim(), kdim(), lambda(), this->tsRef());
-    add(c, conv);
-    return this->underlying().score(c, conv);
+    computeCorners(c);
+    return this->underlying().score(decays() ? splatInterpolate<U, true>()
+                                             : splatInterpolate<U, false>());
+  }
+
+  /* f and its gradient at vars: without decay, the points are warped,
+     whitened and scaled with their derivatives in planes (see
+     transformPointsForward) and splatted in plain scalars, and the gradient
+     of the interpolated sum w.r.t. every point is formed from the grid
+     across its cells, then chained with the planes; the kernels being
+     symmetric, moving a point changes its splat as much as its
+     interpolation, hence twice the derivative of the interpolation; the
+     decay of the decaying grids depends on the order of the splats, so that
+     they are differentiated with forward derivatives */
+  void
+  fdf(const Vector<T, NVars>& vars, Vector<T, 1>* f,
+      Matrix<T, 1, NVars>* df) const
+  {
+    if (df == nullptr)
+    {
+      (*this)(vars, f);
+      return;
+    }
+
+    if (decays())
+    {
+      typedef
+          typename DispersionBase<Dispersion<Derived> >::ADScalar ADScalar;
+      Vector<ADScalar, NVars> adVars;
+      for (int i = 0; i < NVars; ++i)
+      {
+        adVars(i) = ADScalar(vars(i), NVars, i);
+      }
+      Vector<ADScalar, 1> fAD;
+      (*this)(adVars, &fAD);
+      (*f)(0) = fAD(0).value();
+      *df = fAD(0).derivatives().transpose();
+      return;
+    }
+
+    const ForwardBuffers<T>& fb = this->transformPointsForward(vars);
+    computeCorners(fb.cScaled);
+    Convolution<T, NDims, T, false>& conv = convolution<T, false>();
+    add(conv);
+    const T s = interpolateGradient(fb.cScaled, conv, gradient_);
+
+    // chain rule through the score and the planes of the points
+    typedef Eigen::AutoDiffScalar<Vector<T, 1> > ADScore;
+    const ADScore fs = this->underlying().score(ADScore(s, 1, 0));
+    Vector<T, NVars> dfVars;
+    for (int i = 0; i < NVars; ++i)
+    {
+      dfVars(i) = T(0.0);
+      for (int d = 0; d < NDims; ++d)
+      {
+        dfVars(i) += gradient_.row(d).dot(fb.dc.row(i * NDims + d));
+      }
+    }
+    (*f)(0) = fs.value();
+    *df = fs.derivatives()(0) * dfVars.transpose();
   }
 
   void
@@ -135,138 +298,525 @@ class Dispersion : public DispersionBase<Dispersion<Derived> >
     }
   }
 
+  /* decay of the points at the end of their window, which the
+     interpolation weighs them by, and grids of the plain evaluations and of
+     the forward-derivative ones, which only the decaying grids go through */
+  void
+  preparePoints(void)
+  {
+    typedef typename DispersionBase<Dispersion<Derived> >::ADScalar ADScalar;
+    if (decays())
+    {
+      decay_.resize(this->nPoints());
+      for (int k = 0; k < this->nPoints(); ++k)
+      {
+        decay_(k) = std::exp(-lambda() * (this->tsEnd() - this->ts(k)));
+      }
+      buildConvolution<T, true>();
+      buildConvolution<ADScalar, true>();
+    }
+    else
+    {
+      decay_.resize(0);
+      buildConvolution<T, false>();
+    }
+  }
+
  protected:
+  template <typename U, bool Decay>
+  void
+  buildConvolution(void) const
+  {
+    ConvolutionBuffers<U>& ws = convolutions_.template get<U>();
+    ws.template get<Decay>().emplace(dim(), kdim(), lambda(), this->tsRef());
+    ws.tsRef = this->tsRef();
+  }
+
+  // grid of U, cleared, which is built again if it does not fit the points
+  template <typename U, bool Decay>
+  Convolution<U, NDims, T, Decay>&
+  convolution(void) const
+  {
+    ConvolutionBuffers<U>& ws = convolutions_.template get<U>();
+    std::optional<Convolution<U, NDims, T, Decay> >& conv =
+        ws.template get<Decay>();
+    if (!conv || conv->dim() != dim() || conv->kdim() != kdim() ||
+        conv->lambda() != lambda())
+    {
+      buildConvolution<U, Decay>();
+    }
+    else if (Decay && ws.tsRef != this->tsRef())
+    {
+      conv->reset(this->tsRef());
+      ws.tsRef = this->tsRef();
+    }
+    else
+    {
+      conv->resetTouched(this->tsRef());
+    }
+    return *conv;
+  }
+
+  // sum over the points of the grid of their splat interpolated at them
+  template <typename U, bool Decay>
+  U
+  splatInterpolate(void) const
+  {
+    Convolution<U, NDims, T, Decay>& conv = convolution<U, Decay>();
+    add(conv);
+    return interpolate(conv);
+  }
+
+  // corners of the points c, for the splat and the interpolation
   template <typename U>
   void
-  add(const Matrix<U>& c, Convolution<U, NDims, T>& conv) const
+  computeCorners(const Matrix<U>& c) const
   {
     const computeBoundaries<Index, NDims, U> computeBoundaries;
-    Vector<U, NDims> val;
-    Array<Index, NDims> cl, lcMin, lcMax;
+    CornerBuffers<U>& corners = corners_.template get<U>();
+    corners.resize(this->nPoints());
 
-    for (int k = 0; k < this->nPoints(); ++k)
+    parallelBlocks(
+        this->nPoints(), pointBlockSize, [&](const int begin, const int end) {
+          for (int k = begin; k < end; ++k)
+          {
+            computeBoundaries(c.col(k), cMin_, cMax_, corners.lcMin[k],
+                              corners.lcMax[k]);
+            for (int d = 0; d < NDims; ++d)
+            {
+              for (Index i = 0; i < 2; ++i)
+              {
+                const Index cl = corners.lcMin[k][d] + i;
+                corners.weights(2 * d + i, k) =
+                    T(1.0) - ((c(d, k) > cl) ? c(d, k) - cl : cl - c(d, k));
+              }
+            }
+          }
+        });
+  }
+
+  // splats the points, given their corners
+  template <typename U, bool Decay>
+  void
+  add(Convolution<U, NDims, T, Decay>& conv) const
+  {
+    addBands(conv);
+    // no conv update
+  }
+
+  /* splats the points into the grid in bands of value columns along the
+     last dimension, run on the thread pool: the points that reach every
+     band are listed in order, and every band then convolves them, restricted
+     to its columns; each value thus goes through the same updates in the
+     same order as with a single band, so that the grid is the same on any
+     number of bands, which are chosen from the number of points and of
+     columns; the times of the cells before a band, which the previous bands
+     update, are copied beforehand */
+  template <typename U, bool Decay>
+  void
+  addBands(Convolution<U, NDims, T, Decay>& conv) const
+  {
+    constexpr int last = NDims - 1;
+    const CornerBuffers<U>& corners = corners_.template get<U>();
+    SplatBuffers& sb = splatBuffers_;
+    const int nPoints = this->nPoints();
+    const Index kCols = kdim()[last], nCols = dim()[last] + kCols - 1;
+
+    const int nBands =
+        numThreads() == 1
+            ? 1
+            : std::max(1, std::min({4 * numThreads(), nPoints / minBandPoints,
+                                    static_cast<int>(nCols / minBandCols)}));
+    const Index bandCols = (nCols + nBands - 1) / nBands;
+    sb.resizeBands(nBands);
+    for (int b = 0; b <= nBands; ++b)
     {
-      computeBoundaries(c.col(k), cMin_, cMax_, lcMin, lcMax);
-      if constexpr (NDims == 2)
+      sb.colStart[b] = std::min(b * bandCols, nCols);
+    }
+    if (1 < nBands)
+    {
+      findBands(corners, nBands, bandCols, sb);
+    }
+    // cells of the grid per cell along the last dimension, and offsets of the
+    // cells in the order of the grid
+    Array<Index, NDims> stride;
+    stride[0] = 1;
+    for (int d = 1; d < NDims; ++d)
+    {
+      stride[d] = stride[d - 1] * dim()[d - 1];
+    }
+    if constexpr (Decay)
+    {
+      const T* const ts = conv.ts().data();
+      for (int b = 0; b < nBands; ++b)
       {
-        for (cl[0] = lcMin[0]; cl[0] <= lcMax[0]; ++cl[0])
+        const Index haloBegin = haloStart(sb.colStart[b]);
+        sb.halo[b] = Map<const Vector<T> >(
+            ts + haloBegin * stride[last],
+            std::max(Index(0), std::min(sb.colStart[b], Index(dim()[last])) -
+                                   haloBegin) *
+                stride[last]);
+      }
+    }
+
+    threadPool().run(nBands, [&](const int b) {
+      const Index colBegin = sb.colStart[b], colEnd = sb.colStart[b + 1];
+      const Index haloBegin = haloStart(colBegin);
+      Array<Index, NDims>& touchedBegin = sb.touchedBegin[b];
+      Array<Index, NDims>& touchedEnd = sb.touchedEnd[b];
+      touchedBegin = dim();
+      touchedEnd.fill(0);
+
+      Array<Index, NDims> cl;
+      const int nBandPoints =
+          1 < nBands ? sb.bandStart[b + 1] - sb.bandStart[b] : nPoints;
+      for (int i = 0; i < nBandPoints; ++i)
+      {
+        const int k = 1 < nBands ? sb.bandPoints[sb.bandStart[b] + i] : i;
+        const T ts = this->ts(k);
+        const Array<Index, NDims>& lcMin = corners.lcMin[k];
+        const Array<Index, NDims>& lcMax = corners.lcMax[k];
+        if (emptyCorners(lcMin, lcMax))
         {
-          val(0) =
-              T(1.0) - ((c(0, k) > cl[0]) ? c(0, k) - cl[0] : cl[0] - c(0, k));
-          for (cl[1] = lcMin[1]; cl[1] <= lcMax[1]; ++cl[1])
+          continue;
+        }
+        // cells of the point in order, the last dimension innermost
+        std::copy(lcMin.begin(), lcMin.end(), cl.begin());
+        for (;;)
+        {
+          U val0 = corners.weights(cl[0] - lcMin[0], k);
+          for (int d = 1; d < last; ++d)
+          {
+            val0 *= corners.weights(2 * d + cl[d] - lcMin[d], k);
+          }
+          for (cl[last] = std::max(lcMin[last], haloBegin);
+               cl[last] <= lcMax[last] && cl[last] < colEnd; ++cl[last])
+          {
+            const U val =
+                val0 * corners.weights(2 * last + cl[last] - lcMin[last], k);
+            if constexpr (!Decay)
+            {
+              conv.convColumns(cl, val, kernel(), colBegin, colEnd);
+            }
+            else if (colBegin <= cl[last])
+            {
+              conv.convColumns(cl, ts, conv.ts(cl), lambda(), val, kernel(),
+                               colBegin, colEnd);
+              conv.setTs(cl, ts);
+            }
+            else
+            {
+              Index cell = (cl[last] - haloBegin) * stride[last];
+              for (int d = 0; d < last; ++d)
+              {
+                cell += cl[d] * stride[d];
+              }
+              T& tsHalo = sb.halo[b](cell);
+              conv.convColumns(cl, ts, tsHalo, lambda(), val, kernel(),
+                               colBegin, colEnd);
+              tsHalo = ts;
+            }
+            if (colBegin <= cl[last])
+            {
+              for (int d = 0; d < NDims; ++d)
+              {
+                touchedBegin[d] = std::min(touchedBegin[d], cl[d]);
+                touchedEnd[d] = std::max(touchedEnd[d], cl[d] + 1);
+              }
+            }
+          }
+
+          int d = last - 1;
+          for (; 0 <= d && cl[d] == lcMax[d]; --d)
+          {
+            cl[d] = lcMin[d];
+          }
+          if (d < 0)
           {
-            val(1) = T(1.0) -
-                     ((c(1, k) > cl[1]) ? c(1, k) - cl[1] : cl[1] - c(1, k));
-            conv.conv(cl, this->ts(k), val.prod(), kernel());
+            break;
           }
+          ++cl[d];
         }
       }
-      else
+    });
+    for (int b = 0; b < nBands; ++b)
+    {
+      conv.touch(sb.touchedBegin[b], sb.touchedEnd[b]);
+    }
+  }
+
+  // whether the corners of a point hold no cell, as off the grid
+  static bool
+  emptyCorners(const Array<Index, NDims>& lcMin,
+               const Array<Index, NDims>& lcMax)
+  {
+    for (int d = 0; d < NDims; ++d)
+    {
+      if (lcMax[d] < lcMin[d])
       {
-        addIterate<U>(this->ts(k), c.col(k), lcMin, lcMax, val, cl, conv);
+        return true;
       }
     }
-    // no conv update
+    return false;
   }
 
-  template <typename U>
-  void
-  addIterate(const T& ts, const Ref<const Vector<U, NDims> >& c,
-             const Array<Index, NDims>& lcMin, const Array<Index, NDims>& lcMax,
-             Vector<U, NDims>& val, Array<Index, NDims>& cl,
-             Convolution<U, NDims, T>& conv) const
+  // first cell whose values reach the value column col
+  Index
+  haloStart(const Index col) const
   {
-    addIterate<U>(ts, 0, c, lcMin, lcMax, val, cl, conv);
+    return std::min(std::max(Index(0), col - kdim()[NDims - 1] + 1),
+                    Index(dim()[NDims - 1]));
   }
 
+  /* lists the points of every band in order, by a counting sort over blocks
+     of points run on the thread pool */
   template <typename U>
   void
-  addIterate(const T& ts, const int d, const Ref<const Vector<U, NDims> >& c,
-             const Array<Index, NDims>& lcMin, const Array<Index, NDims>& lcMax,
-             Vector<U, NDims>& val, Array<Index, NDims>& cl,
-             Convolution<U, NDims, T>& conv) const
+  findBands(const CornerBuffers<U>& corners, const int nBands,
+            const Index bandCols, SplatBuffers& sb) const
   {
-    if (d >= NDims)
-    {
-      conv.conv(cl, ts, val.prod(), kernel());
-      return;
-    }
+    const int nPoints = this->nPoints();
+    const int nBlocks = (nPoints + pointBlockSize - 1) / pointBlockSize;
+    constexpr int last = NDims - 1;
+    const Index kCols = kdim()[last];
+    sb.pointBands.resize(2 * nPoints);
+    sb.blockCount.assign(nBlocks * nBands, 0);
 
-    for (cl[d] = lcMin[d]; cl[d] <= lcMax[d]; ++cl[d])
+    parallelBlocks(nPoints, pointBlockSize,
+                   [&](const int begin, const int end) {
+                     int* const count =
+                         &sb.blockCount[(begin / pointBlockSize) * nBands];
+                     for (int k = begin; k < end; ++k)
+                     {
+                       const Array<Index, NDims>& lcMin = corners.lcMin[k];
+                       const Array<Index, NDims>& lcMax = corners.lcMax[k];
+                       int& firstBand = sb.pointBands[2 * k];
+                       int& lastBand = sb.pointBands[2 * k + 1];
+                       if (emptyCorners(lcMin, lcMax))
+                       {
+                         firstBand = 0;
+                         lastBand = -1;
+                         continue;
+                       }
+                       firstBand = static_cast<int>(lcMin[last] / bandCols);
+                       lastBand = static_cast<int>(
+                           std::min((lcMax[last] + kCols - 1) / bandCols,
+                                    Index(nBands - 1)));
+                       for (int b = firstBand; b <= lastBand; ++b)
+                       {
+                         ++count[b];
+                       }
+                     }
+                   });
+
+    // offsets of the blocks in every band
+    int offset = 0;
+    for (int b = 0; b < nBands; ++b)
     {
-      val(d) = T(1.0) - ((c(d) > cl[d]) ? c(d) - cl[d] : cl[d] - c(d));
-      addIterate<U>(ts, d + 1, c, lcMin, lcMax, val, cl, conv);
+      sb.bandStart[b] = offset;
+      for (int i = 0; i < nBlocks; ++i)
+      {
+        const int count = sb.blockCount[i * nBands + b];
+        sb.blockCount[i * nBands + b] = offset;
+        offset += count;
+      }
     }
+    sb.bandStart[nBands] = offset;
+    sb.bandPoints.resize(offset);
+
+    parallelBlocks(nPoints, pointBlockSize,
+                   [&](const int begin, const int end) {
+                     int* const next =
+                         &sb.blockCount[(begin / pointBlockSize) * nBands];
+                     for (int k = begin; k < end; ++k)
+                     {
+                       for (int b = sb.pointBands[2 * k];
+                            b <= sb.pointBands[2 * k + 1]; ++b)
+                       {
+                         sb.bandPoints[next[b]++] = k;
+                       }
+                     }
+                   });
   }
 
-  template <typename U>
+  /* runs f(p, k) on the thread pool for the points k of every partition p:
+     the points are split into blocks of pointBlockSize points, which the
+     partitions take in turns, each visiting its points in order */
+  template <typename F>
+  void
+  parallelPoints(const F& f) const
+  {
+    const int nBlocks = (this->nPoints() + pointBlockSize - 1) / pointBlockSize;
+    const int nParts = nPartitions(nBlocks);
+
+    parallelPartitions(nBlocks, [&](const int p) {
+      for (int i = p; i < nBlocks; i += nParts)
+      {
+        const int end = std::min(this->nPoints(), (i + 1) * pointBlockSize);
+        for (int k = i * pointBlockSize; k < end; ++k)
+        {
+          f(p, k);
+        }
+      }
+    });
+  }
+  int
+  nPointPartitions(void) const
+  {
+    return nPartitions((this->nPoints() + pointBlockSize - 1) /
+                       pointBlockSize);
+  }
+
+  /* sum over the points of the grid interpolated at them, given their
+     corners: the partials of the partitions of the points are summed in
+     order, so that the sum is the same on any number of threads */
+  template <typename U, bool Decay>
   U
-  interpolate(const Matrix<U>& c, const Convolution<U, NDims, T>& conv) const
+  interpolate(const Convolution<U, NDims, T, Decay>& conv) const
   {
-    const computeBoundaries<Index, NDims, U> computeBoundaries;
-    Vector<U, NDims> val;
-    Array<Index, NDims> cl, lcMin, lcMax;
-    U f = U(0.0);
+    CornerBuffers<U>& corners = corners_.template get<U>();
+    corners.fPart.assign(nPointPartitions(), U(0.0));
 
-    for (int k = 0; k < this->nPoints(); ++k)
-    {
-      computeBoundaries(c.col(k), cMin_, cMax_, lcMin, lcMax);
+    parallelPoints([&](const int p, const int k) {
+      Vector<U, NDims> val;
+      Array<Index, NDims> cl;
+      U& f = corners.fPart[p];
       if constexpr (NDims == 2)
       {
+        const Array<Index, NDims>& lcMin = corners.lcMin[k];
+        const Array<Index, NDims>& lcMax = corners.lcMax[k];
         for (cl[0] = lcMin[0]; cl[0] <= lcMax[0]; ++cl[0])
         {
-          val(0) =
-              T(1.0) - ((c(0, k) > cl[0]) ? c(0, k) - cl[0] : cl[0] - c(0, k));
+          val(0) = corners.weights(cl[0] - lcMin[0], k);
           for (cl[1] = lcMin[1]; cl[1] <= lcMax[1]; ++cl[1])
           {
-            val(1) = T(1.0) -
-                     ((c(1, k) > cl[1]) ? c(1, k) - cl[1] : cl[1] - c(1, k));
-            f += val.prod() *
-                 std::exp(-lambda() * (this->tsEnd() - this->ts(k))) *
-                 conv.val(cl);
+            val(1) = corners.weights(2 + cl[1] - lcMin[1], k);
+            if constexpr (Decay)
+            {
+              f += val.prod() * decay(k) * conv.val(cl);
+            }
+            else
+            {
+              f += val.prod() * conv.val(cl);
+            }
           }
         }
       }
       else
       {
-        interpolateIterate<U>(this->ts(k), c.col(k), lcMin, lcMax, conv, val,
-                              cl, f);
+        interpolateIterate(k, 0, corners, conv, val, cl, f);
       }
-    }
-    return f;
+    });
+    return sumPartitions(corners.fPart);
   }
 
-  template <typename U>
+  template <typename U, bool Decay>
   void
-  interpolateIterate(const T& ts, const Ref<const Vector<U, NDims> >& c,
-                     const Array<Index, NDims>& lcMin,
-                     const Array<Index, NDims>& lcMax,
-                     const Convolution<U, NDims, T>& conv,
+  interpolateIterate(const int k, const int d, const CornerBuffers<U>& corners,
+                     const Convolution<U, NDims, T, Decay>& conv,
                      Vector<U, NDims>& val, Array<Index, NDims>& cl, U& f) const
   {
-    interpolateIterate<U>(ts, 0, c, lcMin, lcMax, conv, val, cl, f);
+    if (d >= NDims)
+    {
+      if constexpr (Decay)
+      {
+        f += val.prod() * decay(k) * conv.val(cl);
+      }
+      else
+      {
+        f += val.prod() * conv.val(cl);
+      }
+      return;
+    }
+
+    const Array<Index, NDims>& lcMin = corners.lcMin[k];
+    for (cl[d] = lcMin[d]; cl[d] <= corners.lcMax[k][d]; ++cl[d])
+    {
+      val(d) = corners.weights(2 * d + cl[d] - lcMin[d], k);
+      interpolateIterate(k, d + 1, corners, conv, val, cl, f);
+    }
+  }
+
+  /* interpolate of the grid without decay at the points c, and twice the
+     derivatives of the interpolation at a fixed grid w.r.t. the points into
+     g, see fdf; the weight of a point at a cell falls with the distance
+     between them, with slope -1 or 1 */
+  T
+  interpolateGradient(const Ref<const Matrix<T> >& c,
+                      const Convolution<T, NDims, T, false>& conv,
+                      RowMajorMatrix<T>& g) const
+  {
+    CornerBuffers<T>& corners = corners_.template get<T>();
+    corners.fPart.assign(nPointPartitions(), T(0.0));
+    g.resize(NDims, this->nPoints());
+
+    parallelPoints([&](const int p, const int k) {
+      Vector<T, NDims> val, dval, gk(Vector<T, NDims>::Zero());
+      Array<Index, NDims> cl;
+      T& f = corners.fPart[p];
+      if constexpr (NDims == 2)
+      {
+        const Array<Index, NDims>& lcMin = corners.lcMin[k];
+        const Array<Index, NDims>& lcMax = corners.lcMax[k];
+        for (cl[0] = lcMin[0]; cl[0] <= lcMax[0]; ++cl[0])
+        {
+          val(0) = corners.weights(cl[0] - lcMin[0], k);
+          dval(0) = c(0, k) > cl[0] ? T(-1.0) : T(1.0);
+          for (cl[1] = lcMin[1]; cl[1] <= lcMax[1]; ++cl[1])
+          {
+            val(1) = corners.weights(2 + cl[1] - lcMin[1], k);
+            dval(1) = c(1, k) > cl[1] ? T(-1.0) : T(1.0);
+            const T v = conv.val(cl);
+            f += val.prod() * v;
+            gk(0) += dval(0) * val(1) * v;
+            gk(1) += val(0) * dval(1) * v;
+          }
+        }
+      }
+      else
+      {
+        interpolateGradientIterate(c, k, 0, corners, conv, val, dval, cl, f,
+                                   gk);
+      }
+      g.col(k) = T(2.0) * gk;
+    });
+    return sumPartitions(corners.fPart);
   }
 
-  template <typename U>
   void
-  interpolateIterate(const T& ts, const int d,
-                     const Ref<const Vector<U, NDims> >& c,
-                     const Array<Index, NDims>& lcMin,
-                     const Array<Index, NDims>& lcMax,
-                     const Convolution<U, NDims, T>& conv,
-                     Vector<U, NDims>& val, Array<Index, NDims>& cl, U& f) const
+  interpolateGradientIterate(const Ref<const Matrix<T> >& c, const int k,
+                             const int d, const CornerBuffers<T>& corners,
+                             const Convolution<T, NDims, T, false>& conv,
+                             Vector<T, NDims>& val, Vector<T, NDims>& dval,
+                             Array<Index, NDims>& cl, T& f,
+                             Vector<T, NDims>& gk) const
   {
     if (d >= NDims)
     {
-      f += val.prod() * std::exp(-lambda() * (this->tsEnd() - ts)) *
-           conv.val(cl);
+      const T v = conv.val(cl);
+      f += val.prod() * v;
+      for (int e = 0; e < NDims; ++e)
+      {
+        T dv = dval(e) * v;
+        for (int o = 0; o < NDims; ++o)
+        {
+          if (o != e)
+          {
+            dv *= val(o);
+          }
+        }
+        gk(e) += dv;
+      }
       return;
     }
 
-    for (cl[d] = lcMin[d]; cl[d] <= lcMax[d]; ++cl[d])
+    const Array<Index, NDims>& lcMin = corners.lcMin[k];
+    for (cl[d] = lcMin[d]; cl[d] <= corners.lcMax[k][d]; ++cl[d])
     {
-      val(d) = T(1.0) - ((c(d) > cl[d]) ? c(d) - cl[d] : cl[d] - c(d));
-      interpolateIterate<U>(ts, d + 1, c, lcMin, lcMax, conv, val, cl, f);
+      val(d) = corners.weights(2 * d + cl[d] - lcMin[d], k);
+      dval(d) = c(d, k) > cl[d] ? T(-1.0) : T(1.0);
+      interpolateGradientIterate(c, k, d + 1, corners, conv, val, dval, cl, f,
+                                 gk);
     }
   }
 
@@ -44,9 +44,9 @@ class Potential : public Dispersion<Potential<M> >
 
   template <typename U>
   U
-  score(const Matrix<U>& c, const Convolution<U, NDims, T>& conv) const
+  score(const U& s) const
   {
-    return -this->interpolate(c, conv) / this->nPoints();
+    return -s / this->nPoints();
   }
 };
 }  // namespace approximate
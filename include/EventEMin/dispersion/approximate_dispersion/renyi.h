@@ -70,9 +70,9 @@ class Renyi : public Dispersion<Renyi<M> >
 
   template <typename U>
   U
-  score(const Matrix<U>& c, const Convolution<U, NDims, T>& conv) const
+  score(const U& s) const
   {
-    return scale() * log(this->interpolate(c, conv) / this->nPoints());
+    return scale() * log(s / this->nPoints());
   }
 };
 }  // namespace approximate
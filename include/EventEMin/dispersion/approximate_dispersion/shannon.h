@@ -52,9 +52,9 @@ class Shannon : public Dispersion<Shannon<M> >
 
   template <typename U>
   U
-  score(const Matrix<U>& c, const Convolution<U, NDims, T>& conv) const
+  score(const U& s) const
   {
-    return this->interpolate(c, conv) / this->nPoints();
+    return s / this->nPoints();
   }
 };
 }  // namespace approximate
@@ -84,9 +84,9 @@ class SharmaMittal : public Dispersion<SharmaMittal<M> >
 
   template <typename U>
   U
-  score(const Matrix<U>& c, const Convolution<U, NDims, T>& conv) const
+  score(const U& s) const
   {
-    return scale() * pow(this->interpolate(c, conv) / this->nPoints(), gamma());
+    return scale() * pow(s / this->nPoints(), gamma());
   }
 };
 }  // namespace approximate
@@ -71,9 +71,9 @@ class Tsallis : public Dispersion<Tsallis<M> >
 
   template <typename U>
   U
-  score(const Matrix<U>& c, const Convolution<U, NDims, T>& conv) const
+  score(const U& s) const
   {
-    return scale() * this->interpolate(c, conv) / this->nPoints();
+    return scale() * s / this->nPoints();
   }
 };
 }  // namespace approximate
@@ -3,9 +3,12 @@
 
 #include <cassert>
 #include <cmath>
+#include <type_traits>
 
 #include "EventEMin/data_stats.h"
+#include "EventEMin/event/type.h"
 #include "EventEMin/gauss_kernel.h"
+#include "EventEMin/thread_pool.h"
 #include "EventEMin/types_def.h"
 
 namespace EventEMin
@@ -15,6 +18,76 @@ namespace batch
 template <typename Derived>
 struct DispersionTraits;
 
+/* buffers of the evaluations of a measure, one W<U> per scalar U: the buffers
+   of the plain scalar and of the forward-mode scalar of the gradients are
+   kept by the measure, those of any other scalar by the calling thread; they
+   keep their size between evaluations, so that the evaluations of a set of
+   points do not allocate */
+template <template <typename> class W, typename T, int NVars>
+class Workspaces
+{
+ public:
+  typedef Eigen::AutoDiffScalar<Vector<T, NVars> > ADScalar;
+
+ private:
+  W<T> plain_;
+  W<ADScalar> ad_;
+
+ public:
+  template <typename U>
+  W<U>&
+  get(void)
+  {
+    if constexpr (std::is_same<U, T>::value)
+    {
+      return plain_;
+    }
+    else if constexpr (std::is_same<U, ADScalar>::value)
+    {
+      return ad_;
+    }
+    else
+    {
+      static thread_local W<U> w;
+      return w;
+    }
+  }
+};
+
+// warped, whitened and scaled points, and the statistics of the whitening
+template <typename U>
+struct TransformBuffers
+{
+  Matrix<U> cm, cmScaled;
+  DataStats<U> cmStats;
+
+  void
+  resize(const int nDims, const int nPoints)
+  {
+    cm.resize(nDims, nPoints);
+    cmScaled.resize(nDims, nPoints);
+  }
+};
+
+/* warped, whitened and scaled points with their derivatives w.r.t. the
+   variables, as planes of contiguous coordinates (see Model::forward), and
+   the scaled points in the layout of the measures */
+template <typename T>
+struct ForwardBuffers
+{
+  RowMajorMatrix<T> c, dc, tmp;
+  Matrix<T> cScaled;
+
+  void
+  resize(const int nDims, const int nVars, const int nPoints)
+  {
+    c.resize(nDims, nPoints);
+    dc.resize(nVars * nDims, nPoints);
+    tmp.resize(nDims, nPoints);
+    cScaled.resize(nDims, nPoints);
+  }
+};
+
 template <typename Derived>
 class DispersionBase
 {
@@ -34,11 +107,18 @@ class DispersionBase
   typedef Vector<T, ValuesAtCompileTime> ValueType;
 
  private:
+  // points per block of the warp, run on the thread pool
+  static constexpr int warpBlockSize = 1024;
+
   int nPoints_;
 
   Vector<T, NDims> cLimDiff_;
   DataStats<T> cStats_;
 
+  // the evaluations are not reentrant: they share these buffers
+  mutable Workspaces<TransformBuffers, T, NVars> workspaces_;
+  mutable ForwardBuffers<T> forwardBuffers_;
+
  protected:
   const Model model_;
   Map<const Matrix<T> > c_;
@@ -141,8 +221,9 @@ class DispersionBase
     if (whiten_)
     {
       cStats_.computeMoments(c_);
+      const Matrix<T, NDims, NDims> cov(cStats_.cov());
       Matrix<T, NDims, NDims> w;
-      computeWhitening(cStats_.cov(), w);
+      computeWhitening(cov, w);
       Matrix<T> cScaled;
       whitenPoints(cStats_.centred(), w, cScaled);
       cStats_.computeLimits(cScaled);
@@ -152,37 +233,167 @@ class DispersionBase
       cStats_.computeLimits(c_);
     }
     cLimDiff_ = (cStats_.max() - cStats_.min()).array() + T(1.0e-8);
+    workspaces_.template get<T>().resize(NDims, nPoints());
+    workspaces_.template get<ADScalar>().resize(NDims, nPoints());
+    forwardBuffers_.resize(NDims, NVars, nPoints());
 
     this->underlying().computeDimScale();
+    this->underlying().preparePoints();
+  }
+
+  void
+  assignPoints(const EventBlockRef<T, NDims>& evs, const bool whiten = true)
+  {
+    assignPoints(evs.c, evs.ts, evs.polarity, whiten);
+  }
+
+  // state of the measures that depends on the points, none by default
+  void
+  preparePoints(void)
+  {
   }
 
   template <typename U>
   void
   operator()(const Vector<U, NVars>& vars, Vector<U, 1>* f) const
   {
-    Matrix<U> cm(static_cast<int>(NDims), nPoints()),
-        cmScaled(static_cast<int>(NDims), nPoints());
+    (*f)(0) = this->underlying().compute(transformPoints(vars));
+  }
+
+ protected:
+  typedef typename Workspaces<TransformBuffers, T, NVars>::ADScalar ADScalar;
+
+  // warps, whitens and scales the points, into the buffers of U
+  template <typename U>
+  const Matrix<U>&
+  transformPoints(const Vector<U, NVars>& vars) const
+  {
+    TransformBuffers<U>& ws = workspaces_.template get<U>();
+    ws.resize(NDims, nPoints());
 
-    modelPoints(vars, cm);
+    modelPoints(vars, ws.cm);
     if (whiten_)
     {
-      DataStats<U> cmStats;
-      cmStats.computeMoments(cm);
+      ws.cmStats.computeMoments(ws.cm);
+      const Matrix<U, NDims, NDims> cov(ws.cmStats.cov());
       Matrix<U, NDims, NDims> w;
-      computeWhitening(cmStats.cov(), w);
-      whitenPoints(cmStats.centred(), w, cm);
+      computeWhitening(cov, w);
+      whitenPoints(ws.cmStats.centred(), w, ws.cm);
     }
-    scalePoints<U>(cm, cmScaled);
+    scalePoints<U>(ws.cm, ws.cmScaled);
+    return ws.cmScaled;
+  }
 
-    (*f)(0) = this->underlying().compute(cmScaled);
+  /* warps, whitens and scales the points, with their derivatives w.r.t.
+     vars in planes, which the per-dimension steps go through as dense
+     vectors rather than as one small gradient per coordinate */
+  const ForwardBuffers<T>&
+  transformPointsForward(const Vector<T, NVars>& vars) const
+  {
+    ForwardBuffers<T>& fb = forwardBuffers_;
+    fb.resize(NDims, NVars, nPoints());
+
+    parallelBlocks(nPoints(), warpBlockSize,
+                   [&](const int begin, const int end) {
+                     model_.forward(vars, c().middleCols(begin, end - begin),
+                                    ts().segment(begin, end - begin), tsRef(),
+                                    fb.c.middleCols(begin, end - begin),
+                                    fb.dc.middleCols(begin, end - begin));
+                   });
+    if (whiten_)
+    {
+      whitenForward(fb);
+    }
+    for (int d = 0; d < NDims; ++d)
+    {
+      const T scale =
+          (this->underlying().dimScale(d) - this->underlying().offset()) /
+          cLimDiff_(d);
+      fb.c.row(d) = scale * (fb.c.row(d).array() - cStats_.min()(d)) +
+                    this->underlying().halfOffset();
+      for (int i = 0; i < NVars; ++i)
+      {
+        fb.dc.row(i * NDims + d) *= scale;
+      }
+    }
+    fb.cScaled = fb.c;
+    return fb;
   }
 
- protected:
   template <typename U>
   void
   modelPoints(const Vector<U, NVars>& vars, Matrix<U>& cm) const
   {
-    model_(vars, c(), ts(), cm);
+    parallelBlocks(nPoints(), warpBlockSize,
+                   [&](const int begin, const int end) {
+                     Vector<U, NDims> vcm;
+                     for (int k = begin; k < end; ++k)
+                     {
+                       model_(vars, &vcm, c().col(k), ts(k) - tsRef());
+                       cm.col(k) = vcm;
+                     }
+                   });
+  }
+
+  /* whitens the points of fb and their derivatives: the derivatives of the
+     whitening are those of its closed form w.r.t. the covariance, whose
+     derivatives are formed from the planes */
+  void
+  whitenForward(ForwardBuffers<T>& fb) const
+  {
+    const Vector<T, NDims> mean(fb.c.rowwise().mean());
+    const Vector<T, NVars * NDims> dMean(fb.dc.rowwise().mean());
+    fb.c.colwise() -= mean;
+    fb.dc.colwise() -= dMean;
+
+    const T nMinus1 = T(nPoints() - 1);
+    Matrix<T, NDims, NDims> cov, dCov;
+    cov.noalias() = fb.c * fb.c.transpose();
+    Matrix<ADScalar, NDims, NDims> adCov;
+    for (int j = 0; j < NDims; ++j)
+    {
+      for (int d = 0; d < NDims; ++d)
+      {
+        adCov(d, j) = ADScalar(cov(d, j) / nMinus1, Vector<T, NVars>::Zero());
+      }
+    }
+    for (int i = 0; i < NVars; ++i)
+    {
+      dCov.noalias() = fb.dc.middleRows(i * NDims, NDims) * fb.c.transpose();
+      for (int j = 0; j < NDims; ++j)
+      {
+        for (int d = 0; d < NDims; ++d)
+        {
+          adCov(d, j).derivatives()(i) = (dCov(d, j) + dCov(j, d)) / nMinus1;
+        }
+      }
+    }
+    Matrix<ADScalar, NDims, NDims> adW;
+    computeWhitening(adCov, adW);
+
+    Matrix<T, NDims, NDims> w, dW;
+    for (int j = 0; j < NDims; ++j)
+    {
+      for (int d = 0; d < NDims; ++d)
+      {
+        w(d, j) = adW(d, j).value();
+      }
+    }
+    for (int i = 0; i < NVars; ++i)
+    {
+      for (int j = 0; j < NDims; ++j)
+      {
+        for (int d = 0; d < NDims; ++d)
+        {
+          dW(d, j) = adW(d, j).derivatives()(i);
+        }
+      }
+      fb.tmp.noalias() = w * fb.dc.middleRows(i * NDims, NDims);
+      fb.tmp.noalias() += dW * fb.c;
+      fb.dc.middleRows(i * NDims, NDims) = fb.tmp;
+    }
+    fb.tmp.noalias() = w * fb.c;
+    fb.c.swap(fb.tmp);
   }
 
   template <typename U>
@@ -0,0 +1,203 @@
+#ifndef EVENT_EMIN_CELL_LIST_H
+#define EVENT_EMIN_CELL_LIST_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "EventEMin/types_def.h"
+#include "EventEMin/utilities.h"
+
+namespace EventEMin
+{
+/* uniform grid of cells of side cellSize over a set of points; the points are
+   sorted by cell, so that the points of every cell are contiguous; the cells
+   are enlarged when more than nCellsMax would be needed */
+template <typename T, int N>
+class CellList
+{
+ private:
+  T cellSize_;
+  Vector<T, N> origin_;
+  Array<int, N> dim_, stride_;
+
+  // points of cell i are at sorted positions [start_[i], start_[i + 1])
+  std::vector<int> start_, cell_, order_;
+  // next free sorted position of every cell while sorting
+  std::vector<int> next_;
+
+ public:
+  CellList(void) : cellSize_(T(0.0)) {}
+
+  T
+  cellSize(void) const
+  {
+    return cellSize_;
+  }
+  int
+  nCells(void) const
+  {
+    return static_cast<int>(start_.size()) - 1;
+  }
+  int
+  nPoints(void) const
+  {
+    return static_cast<int>(order_.size());
+  }
+  int
+  begin(const int i) const
+  {
+    assert(0 <= i && i < nCells());
+    return start_[i];
+  }
+  int
+  end(const int i) const
+  {
+    assert(0 <= i && i < nCells());
+    return start_[i + 1];
+  }
+  int
+  size(const int i) const
+  {
+    return end(i) - begin(i);
+  }
+  // index of the point at a sorted position
+  int
+  order(const int pos) const
+  {
+    assert(0 <= pos && pos < nPoints());
+    return order_[pos];
+  }
+
+  template <typename U>
+  void
+  build(const Matrix<U>& c, const T& cellSize, const int nCellsMax)
+  {
+    assert(c.rows() == N);
+    assert(T(0.0) < cellSize);
+    assert(0 < nCellsMax);
+
+    const int n = c.cols();
+    Vector<T, N> cMin, cMax;
+    cMin.setConstant(std::numeric_limits<T>::max());
+    cMax.setConstant(std::numeric_limits<T>::lowest());
+    for (int k = 0; k < n; ++k)
+    {
+      for (int d = 0; d < N; ++d)
+      {
+        const T x = scalarValue(c(d, k));
+        cMin(d) = std::min(cMin(d), x);
+        cMax(d) = std::max(cMax(d), x);
+      }
+    }
+    if (n == 0)
+    {
+      cMin.setZero();
+      cMax.setZero();
+    }
+    origin_ = cMin;
+
+    cellSize_ = cellSize;
+    for (;;)
+    {
+      double nCells = 1.0;
+      for (int d = 0; d < N; ++d)
+      {
+        dim_[d] = static_cast<int>((cMax(d) - cMin(d)) / cellSize_) + 1;
+        nCells *= dim_[d];
+      }
+      if (nCells <= nCellsMax)
+      {
+        break;
+      }
+      cellSize_ *= T(std::pow(nCells / nCellsMax, 1.0 / N) * 1.0001);
+    }
+    stride_[0] = 1;
+    for (int d = 1; d < N; ++d)
+    {
+      stride_[d] = stride_[d - 1] * dim_[d - 1];
+    }
+
+    // counting sort of the points by cell
+    start_.assign(stride_[N - 1] * dim_[N - 1] + 1, 0);
+    cell_.resize(n);
+    order_.resize(n);
+    for (int k = 0; k < n; ++k)
+    {
+      int i = 0;
+      for (int d = 0; d < N; ++d)
+      {
+        const int ci = std::min(
+            static_cast<int>((scalarValue(c(d, k)) - origin_(d)) / cellSize_),
+            dim_[d] - 1);
+        i += ci * stride_[d];
+      }
+      cell_[k] = i;
+      ++start_[i + 1];
+    }
+    for (int i = 0; i < nCells(); ++i)
+    {
+      start_[i + 1] += start_[i];
+    }
+    next_.assign(start_.begin(), start_.end() - 1);
+    for (int k = 0; k < n; ++k)
+    {
+      order_[next_[cell_[k]]++] = k;
+    }
+  }
+
+  // copy of the points in sorted order
+  template <typename U>
+  void
+  sort(const Matrix<U>& c, Matrix<U>& cs) const
+  {
+    cs.resize(N, nPoints());
+    for (int pos = 0; pos < nPoints(); ++pos)
+    {
+      cs.col(pos) = c.col(order_[pos]);
+    }
+  }
+
+  // calls f(j) for every cell j adjacent to cell i, i included
+  template <typename F>
+  void
+  forEachNeighbour(const int i, F&& f) const
+  {
+    Array<int, N> ci;
+    for (int d = N - 1, r = i; d >= 0; --d)
+    {
+      ci[d] = r / stride_[d];
+      r -= ci[d] * stride_[d];
+    }
+
+    int nNeighbours = 1;
+    for (int d = 0; d < N; ++d)
+    {
+      nNeighbours *= 3;
+    }
+    for (int o = 0; o < nNeighbours; ++o)
+    {
+      int j = 0;
+      bool inside = true;
+      for (int d = 0, r = o; d < N; ++d, r /= 3)
+      {
+        const int cj = ci[d] + r % 3 - 1;
+        if (cj < 0 || cj >= dim_[d])
+        {
+          inside = false;
+          break;
+        }
+        j += cj * stride_[d];
+      }
+      if (inside)
+      {
+        f(j);
+      }
+    }
+  }
+};
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_CELL_LIST_H
@@ -1,11 +1,18 @@
 #ifndef EVENT_EMIN_DISPERSION_IMPL_H
 #define EVENT_EMIN_DISPERSION_IMPL_H
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
 
 #include "EventEMin/dispersion/dispersion.h"
+#include "EventEMin/dispersion/dispersion/cell_list.h"
+#include "EventEMin/dispersion/dispersion/kd_tree.h"
+#include "EventEMin/thread_pool.h"
+#include "EventEMin/utilities.h"
 
 namespace EventEMin
 {
@@ -19,6 +26,8 @@ class Dispersion : public DispersionBase<Dispersion<Derived> >
  public:
   typedef typename DispersionTraits<Dispersion<Derived> >::Model Model;
   typedef typename DispersionTraits<Dispersion<Derived> >::T T;
+  // scalar of the gradients w.r.t. the points, summed over many pairs
+  typedef typename Accumulator<T>::type TSum;
 
   enum
   {
@@ -27,13 +36,181 @@ class Dispersion : public DispersionBase<Dispersion<Derived> >
   };
 
  private:
+  // points per tile of the pairwise sums
+  static constexpr int tileSize = 256;
+  // strata of the sampled sums: blocks of time, split by position
+  static constexpr int nTimeStrata = 8, nSpaceStrata = 8;
+
+  // pairs of strata a <= b, and the samples drawn from them
+  struct SampledStrata
+  {
+    int a, b;
+    long long first, nSamples;
+    // pairs of the strata per sample
+    double weight;
+  };
+
+  // buffers of the pairwise sums with scalar U
+  template <typename U>
+  struct PairBuffers
+  {
+    // points transposed or sorted, and centroids of the nodes of the kd-tree
+    Matrix<U, Dynamic, NDims> ct;
+    Matrix<U> cs, centroids;
+    CellList<T, NDims> cells;
+    KdTree<T, NDims> tree;
+    std::vector<int> level;
+    std::vector<std::pair<int, int> > nodePairs;
+    // partials and exponents of the partitions
+    std::vector<CompensatedSum<U> > sPart;
+    std::vector<long long> nPairsPart;
+    std::vector<T> errorPart;
+    std::vector<Vector<U> > cDiffPow, dcDiffPow;
+
+    // nParts zeroed partials, and exponents of at least size pairs
+    void
+    resizePartitions(const int nParts, const int size)
+    {
+      sPart.assign(nParts, CompensatedSum<U>());
+      nPairsPart.assign(nParts, 0);
+      errorPart.assign(nParts, T(0.0));
+      if (static_cast<int>(cDiffPow.size()) < nParts)
+      {
+        cDiffPow.resize(nParts);
+        dcDiffPow.resize(nParts);
+      }
+      for (int p = 0; p < nParts; ++p)
+      {
+        if (cDiffPow[p].size() < size)
+        {
+          cDiffPow[p].resize(size);
+        }
+        if (dcDiffPow[p].size() < size)
+        {
+          dcDiffPow[p].resize(size);
+        }
+      }
+    }
+  };
+
+  // buffers of the analytic gradients
+  struct GradientBuffers
+  {
+    // gradient of the pairwise sum w.r.t. the points
+    Matrix<TSum> g, gs;
+    Matrix<TSum, Dynamic, NDims> gt;
+    // gradients of the partitions on the points of a band of columns
+    std::vector<Matrix<TSum, Dynamic, NDims> > gtPart;
+    std::vector<Matrix<T, Dynamic, NDims> > gtTile;
+    std::vector<Matrix<TSum> > gsPart;
+
+    void
+    resizePartitions(const int nParts)
+    {
+      if (static_cast<int>(gtPart.size()) < nParts)
+      {
+        gtPart.resize(nParts);
+        gtTile.resize(nParts);
+        gsPart.resize(nParts);
+      }
+    }
+  };
+
   const T dimScaleMax_;
   Array<Index, NDims> dim_;
 
+  // pairs farther than cutoff_ are neglected, unless it is 0
+  T cutoff_;
+  // error tolerance of the dual-tree sums, unless it is 0
+  T tolerance_;
+  // pairs sampled per evaluation, unless it is 0
+  long long nSamples_;
+  std::uint64_t seed_;
+  mutable T truncationError_;
+
+  // points sorted by stratum, stratum i at positions
+  // [strataStart_[i], strataStart_[i + 1])
+  std::vector<int> strataOrder_, strataStart_;
+  // pairs of strata (a, b), those of stratum a at positions
+  // [sampledStrataStart_[a], sampledStrataStart_[a + 1]) in increasing b
+  std::vector<SampledStrata> sampledStrata_;
+  std::vector<int> sampledStrataStart_;
+
+  // the evaluations are not reentrant: they share these buffers
+  mutable Workspaces<PairBuffers, T, NVars> pairWorkspaces_;
+  mutable GradientBuffers gradientBuffers_;
+
  public:
   Dispersion(const T& dimScaleMax)
-      : DispersionBase<Dispersion<Derived> >(), dimScaleMax_(dimScaleMax)
+      : DispersionBase<Dispersion<Derived> >(),
+        dimScaleMax_(dimScaleMax),
+        cutoff_(T(0.0)),
+        tolerance_(T(0.0)),
+        nSamples_(0),
+        seed_(0),
+        truncationError_(T(0.0))
+  {
+  }
+
+  /* restricts the pairwise sums to the pairs of points closer than cutoff in
+     the scaled space, found through a cell list, so that the cost grows
+     linearly with the number of points; 0 evaluates every pair */
+  void
+  truncate(const T& cutoff)
+  {
+    assert(T(0.0) <= cutoff);
+    cutoff_ = cutoff;
+  }
+  T
+  cutoff(void) const
+  {
+    return cutoff_;
+  }
+  /* evaluates the pairwise sums over a kd-tree, approximating the terms of
+     every pair of nodes whose terms differ by less than tol / nPoints by the
+     term of their centroids, so that the error of the normalised pairwise sum
+     stays below tol; 0 evaluates every pair, takes precedence over truncate */
+  void
+  approximate(const T& tol)
+  {
+    assert(T(0.0) <= tol);
+    tolerance_ = tol;
+  }
+  T
+  tolerance(void) const
+  {
+    return tolerance_;
+  }
+  /* estimates the pairwise sums from nSamples pairs, drawn from the pairs of
+     strata of points (blocks of time split by position) in proportion to
+     their number of pairs; the pairs are determined by seed and the points,
+     so that the estimate is a deterministic function of the variables;
+     0 evaluates every pair, truncate and approximate take precedence */
+  void
+  sample(const long long nSamples, const std::uint64_t seed = 0)
+  {
+    assert(0 <= nSamples);
+    nSamples_ = nSamples;
+    seed_ = seed;
+    preparePoints();
+  }
+  long long
+  nSamples(void) const
   {
+    return nSamples_;
+  }
+  std::uint64_t
+  seed(void) const
+  {
+    return seed_;
+  }
+  /* bound on the error of the normalised pairwise sum (the sum divided by the
+     number of points) in the last evaluation, due to the neglected or
+     approximated pairs, the sampling noise aside */
+  T
+  truncationError(void) const
+  {
+    return truncationError_;
   }
 
   T
@@ -57,27 +234,489 @@ class Dispersion : public DispersionBase<Dispersion<Derived> >
   U
   compute(const Matrix<U>& c) const
   {
-    U s = U(0.0);
-#ifdef _OPENMP
-#pragma omp parallel shared(c, s)
-#endif
+    if (T(0.0) < tolerance())
+    {
+      return computeDualTree(c);
+    }
+    if (T(0.0) < cutoff())
     {
-      Matrix<U> cDiff;
-      Vector<U> cDiffPow;
+      return computeTruncated(c);
+    }
+    if (0 < nSamples())
+    {
+      return computeSampled(c);
+    }
+    return computeTiled(c);
+  }
 
-#ifdef _OPENMP
-#pragma omp declare reduction(sum:U : omp_out += omp_in) initializer(omp_priv = U(0.0))
-#pragma omp for reduction(sum : s)
-#endif
-      for (int k = 0; k < this->nPoints(); ++k)
+  /* f and its gradient at vars: the points are warped, whitened and scaled
+     with their derivatives in planes (see transformPointsForward), which is
+     linear in the number of points, and the pairwise sum and its gradient
+     w.r.t. the points are computed in one pass over the pairs in plain
+     scalars, then chained with the planes; the dual-tree sums are
+     differentiated through the points with forward derivatives */
+  void
+  fdf(const Vector<T, NVars>& vars, Vector<T, 1>* f,
+      Matrix<T, 1, NVars>* df) const
+  {
+    if (df == nullptr)
+    {
+      (*this)(vars, f);
+      return;
+    }
+
+    if (T(0.0) < tolerance())
+    {
+      typedef
+          typename DispersionBase<Dispersion<Derived> >::ADScalar ADScalar;
+      Vector<ADScalar, NVars> adVars;
+      for (int i = 0; i < NVars; ++i)
       {
-        pointsDiff(k, c, cDiff);
-        pointsPow(cDiff, cDiffPow);
-        s += this->underlying().partialScore(cDiffPow);
+        adVars(i) = ADScalar(vars(i), NVars, i);
       }
+      const ADScalar fAD = computeDualTree(this->transformPoints(adVars));
+      (*f)(0) = fAD.value();
+      *df = fAD.derivatives().transpose();
+      return;
     }
 
-    return this->underlying().score(s);
+    const ForwardBuffers<T>& fb = this->transformPointsForward(vars);
+    GradientBuffers& gb = gradientBuffers_;
+    const T s = T(0.0) < cutoff() ? computeTruncatedGradient(fb.cScaled, gb.g)
+                : 0 < nSamples()
+                    ? computeSampledGradient(fb.cScaled, gb.g)
+                    : computeTiledGradient(fb.cScaled, gb.g);
+
+    // chain rule through the score and the planes of the points
+    typedef Eigen::AutoDiffScalar<Vector<T, 1> > ADScore;
+    const ADScore fs = this->underlying().score(ADScore(s, 1, 0));
+    Vector<TSum, NVars> dfVars;
+    for (int i = 0; i < NVars; ++i)
+    {
+      dfVars(i) = TSum(0.0);
+      for (int d = 0; d < NDims; ++d)
+      {
+        dfVars(i) += gb.g.row(d).dot(
+            fb.dc.row(i * NDims + d).template cast<TSum>());
+      }
+    }
+    (*f)(0) = fs.value();
+    *df = fs.derivatives()(0) * dfVars.template cast<T>().transpose();
+  }
+  /* sum over every pair of points, each evaluated once: the points are
+     split into tiles of tileSize points, whose coordinates are contiguous
+     per dimension, and the pairs of every pair of tiles (i <= j) are
+     evaluated together through a per-partition buffer of exponents; the
+     partitions take the rows i of tiles in turns */
+  template <typename U>
+  U
+  computeTiled(const Matrix<U>& c) const
+  {
+    PairBuffers<U>& ws = pairWorkspaces_.template get<U>();
+    ws.ct = c.transpose();
+    const int nTiles = (this->nPoints() + tileSize - 1) / tileSize;
+    const int nParts = nPartitions(nTiles);
+    ws.resizePartitions(nParts, tileSize);
+
+    parallelPartitions(nTiles, [&](const int p) {
+      const FlushDenormals flushDenormals;
+      for (int i = p; i < nTiles; i += nParts)
+      {
+        for (int j = i; j < nTiles; ++j)
+        {
+          ws.sPart[p] += tilePairs(ws.ct, i, j, ws.cDiffPow[p]);
+        }
+      }
+    });
+    const CompensatedSum<U> s(sumPartitions(ws.sPart));
+
+    // the pairs off the diagonal appear in both orders
+    const U diagonalPow = U(0.0);
+    const U sTotal = T(2.0) * s.value() +
+                     T(this->nPoints()) *
+                         this->underlying().template partialScore<U>(
+                             Map<const Vector<U> >(&diagonalPow, 1));
+    truncationError_ = T(0.0);
+    return this->underlying().score(sTotal);
+  }
+
+  // computeTiled, and the gradient of the pairwise sum w.r.t. the points
+  T
+  computeTiledGradient(const Matrix<T>& c, Matrix<TSum>& g) const
+  {
+    PairBuffers<T>& ws = pairWorkspaces_.template get<T>();
+    GradientBuffers& gb = gradientBuffers_;
+    ws.ct = c.transpose();
+    const int nTiles = (this->nPoints() + tileSize - 1) / tileSize;
+    ws.resizePartitions(nPartitions(nTiles), tileSize);
+    gb.resizePartitions(nPartitions(nTiles));
+    gb.gt.setZero(this->nPoints(), NDims);
+
+    /* the pairs of a tile update the gradient of the points of both tiles:
+       the columns j of tiles are taken in bands, in turns, and the
+       partitions take the rows i of tiles of a band in turns; each updates
+       the points of its rows in place and gathers those of the band, which
+       are added in order once the band is done */
+    const int bandTiles = (nTiles + maxPartitions - 1) / maxPartitions;
+    for (int jBand = 0; jBand < nTiles; jBand += bandTiles)
+    {
+      const int jBandEnd = std::min(jBand + bandTiles, nTiles);
+      const int bandBegin = jBand * tileSize,
+                bandSize =
+                    std::min(jBandEnd * tileSize, this->nPoints()) - bandBegin;
+      const int nParts = nPartitions(jBandEnd);
+      parallelPartitions(jBandEnd, [&](const int p) {
+        const FlushDenormals flushDenormals;
+        Matrix<T, Dynamic, NDims>& gtTile = gb.gtTile[p];
+        Matrix<TSum, Dynamic, NDims>& gtBand = gb.gtPart[p];
+        if (gtTile.rows() < tileSize)
+        {
+          gtTile.resize(tileSize, NDims);
+        }
+        if (gtBand.rows() < bandSize)
+        {
+          gtBand.resize(bandTiles * tileSize, NDims);
+        }
+        gtBand.topRows(bandSize).setZero();
+        for (int i = p; i < jBandEnd; i += nParts)
+        {
+          for (int j = std::max(i, jBand); j < jBandEnd; ++j)
+          {
+            ws.sPart[p] += tilePairsGradient(ws.ct, i, j, ws.cDiffPow[p],
+                                             ws.dcDiffPow[p], gtTile, gb.gt,
+                                             gtBand, bandBegin);
+          }
+        }
+      });
+      for (int p = 0; p < nParts; ++p)
+      {
+        gb.gt.middleRows(bandBegin, bandSize) +=
+            gb.gtPart[p].topRows(bandSize);
+      }
+    }
+    const CompensatedSum<T> s(sumPartitions(ws.sPart));
+
+    // the pairs off the diagonal appear in both orders
+    const T diagonalPow = T(0.0);
+    g.resize(static_cast<int>(NDims), this->nPoints());
+    g = TSum(2.0) * gb.gt.transpose();
+    truncationError_ = T(0.0);
+    return T(2.0) * s.value() + T(this->nPoints()) *
+                            this->underlying().template partialScore<T>(
+                                Map<const Vector<T> >(&diagonalPow, 1));
+  }
+
+  template <typename U>
+  U
+  computeTruncated(const Matrix<U>& c) const
+  {
+    PairBuffers<U>& ws = pairWorkspaces_.template get<U>();
+    const CellList<T, NDims>& cells = ws.cells;
+    ws.cells.build(c, cutoff(), std::max(4 * this->nPoints(), 4096));
+    cells.sort(c, ws.cs);
+    const Matrix<U>& cs = ws.cs;
+
+    const int nParts = nPartitions(cells.nCells());
+    ws.resizePartitions(nParts, 0);
+    parallelPartitions(cells.nCells(), [&](const int p) {
+      Vector<U>& cDiffPow = ws.cDiffPow[p];
+      for (int i = p; i < cells.nCells(); i += nParts)
+      {
+        if (cells.size(i) == 0)
+        {
+          continue;
+        }
+        int m = 0;
+        cells.forEachNeighbour(i, [&](const int j) { m += cells.size(j); });
+        if (cDiffPow.size() < m)
+        {
+          cDiffPow.resize(m);
+        }
+        for (int k = cells.begin(i); k < cells.end(i); ++k)
+        {
+          int n = 0;
+          cells.forEachNeighbour(i, [&](const int j) {
+            for (int l = cells.begin(j); l < cells.end(j); ++l, ++n)
+            {
+              cDiffPow(n) = T(-0.5) * (cs.col(l) - cs.col(k)).squaredNorm();
+            }
+          });
+          ws.sPart[p] +=
+              this->underlying().template partialScore<U>(cDiffPow.head(m));
+        }
+        ws.nPairsPart[p] += static_cast<long long>(cells.size(i)) * m;
+      }
+    });
+
+    computeTruncationError(sumPartitions(ws.nPairsPart));
+    return this->underlying().score(sumPartitions(ws.sPart).value());
+  }
+
+  // computeTruncated, and the gradient of the pairwise sum w.r.t. the points
+  T
+  computeTruncatedGradient(const Matrix<T>& c, Matrix<TSum>& g) const
+  {
+    PairBuffers<T>& ws = pairWorkspaces_.template get<T>();
+    GradientBuffers& gb = gradientBuffers_;
+    const CellList<T, NDims>& cells = ws.cells;
+    ws.cells.build(c, cutoff(), std::max(4 * this->nPoints(), 4096));
+    cells.sort(c, ws.cs);
+    const Matrix<T>& cs = ws.cs;
+    gb.gs.resize(static_cast<int>(NDims), this->nPoints());
+
+    const int nParts = nPartitions(cells.nCells());
+    ws.resizePartitions(nParts, 0);
+    parallelPartitions(cells.nCells(), [&](const int p) {
+      Vector<T>& cDiffPow = ws.cDiffPow[p];
+      Vector<T>& dcDiffPow = ws.dcDiffPow[p];
+      for (int i = p; i < cells.nCells(); i += nParts)
+      {
+        if (cells.size(i) == 0)
+        {
+          continue;
+        }
+        int m = 0;
+        cells.forEachNeighbour(i, [&](const int j) { m += cells.size(j); });
+        if (cDiffPow.size() < m)
+        {
+          cDiffPow.resize(m);
+        }
+        if (dcDiffPow.size() < m)
+        {
+          dcDiffPow.resize(m);
+        }
+        for (int k = cells.begin(i); k < cells.end(i); ++k)
+        {
+          int n = 0;
+          cells.forEachNeighbour(i, [&](const int j) {
+            for (int l = cells.begin(j); l < cells.end(j); ++l, ++n)
+            {
+              cDiffPow(n) = T(-0.5) * (cs.col(l) - cs.col(k)).squaredNorm();
+            }
+          });
+          ws.sPart[p] += this->underlying().partialScoreGradient(
+              cDiffPow.head(m), dcDiffPow.head(m));
+          // every pair appears in both orders
+          Vector<TSum, NDims> gk(Vector<TSum, NDims>::Zero());
+          n = 0;
+          cells.forEachNeighbour(i, [&](const int j) {
+            for (int l = cells.begin(j); l < cells.end(j); ++l, ++n)
+            {
+              gk += (dcDiffPow(n) * (cs.col(l) - cs.col(k)))
+                        .template cast<TSum>();
+            }
+          });
+          gb.gs.col(k) = TSum(2.0) * gk;
+        }
+        ws.nPairsPart[p] += static_cast<long long>(cells.size(i)) * m;
+      }
+    });
+
+    g.resize(static_cast<int>(NDims), this->nPoints());
+    for (int pos = 0; pos < this->nPoints(); ++pos)
+    {
+      g.col(cells.order(pos)) = gb.gs.col(pos);
+    }
+    computeTruncationError(sumPartitions(ws.nPairsPart));
+    return sumPartitions(ws.sPart).value();
+  }
+
+  template <typename U>
+  U
+  computeSampled(const Matrix<U>& c) const
+  {
+    PairBuffers<U>& ws = pairWorkspaces_.template get<U>();
+    ws.cs.resize(static_cast<int>(NDims), this->nPoints());
+    for (int pos = 0; pos < this->nPoints(); ++pos)
+    {
+      ws.cs.col(pos) = c.col(strataOrder_[pos]);
+    }
+    const Matrix<U>& cs = ws.cs;
+
+    const int nStrata = static_cast<int>(sampledStrata_.size());
+    const int nParts = nPartitions(nStrata);
+    ws.resizePartitions(nParts, tileSize);
+    parallelPartitions(nStrata, [&](const int p) {
+      const FlushDenormals flushDenormals;
+      Vector<U>& cDiffPow = ws.cDiffPow[p];
+      int k[tileSize], l[tileSize];
+      for (int i = p; i < nStrata; i += nParts)
+      {
+        const SampledStrata& st = sampledStrata_[i];
+        CompensatedSum<U> sStrata;
+        for (long long t = 0; t < st.nSamples; t += tileSize)
+        {
+          const int m =
+              static_cast<int>(std::min<long long>(tileSize, st.nSamples - t));
+          samplePairs(st, t, m, k, l);
+          for (int n = 0; n < m; ++n)
+          {
+            cDiffPow(n) = T(-0.5) * (cs.col(l[n]) - cs.col(k[n])).squaredNorm();
+          }
+          sStrata +=
+              this->underlying().template partialScore<U>(cDiffPow.head(m));
+        }
+        ws.sPart[p] += T(st.weight) * sStrata.value();
+      }
+    });
+    const CompensatedSum<U> s(sumPartitions(ws.sPart));
+
+    // the pairs off the diagonal appear in both orders
+    const U diagonalPow = U(0.0);
+    const U sTotal = T(2.0) * s.value() +
+                     T(this->nPoints()) *
+                         this->underlying().template partialScore<U>(
+                             Map<const Vector<U> >(&diagonalPow, 1));
+    truncationError_ = T(0.0);
+    return this->underlying().score(sTotal);
+  }
+
+  // computeSampled, and the gradient of the pairwise sum w.r.t. the points
+  T
+  computeSampledGradient(const Matrix<T>& c, Matrix<TSum>& g) const
+  {
+    PairBuffers<T>& ws = pairWorkspaces_.template get<T>();
+    GradientBuffers& gb = gradientBuffers_;
+    ws.cs.resize(static_cast<int>(NDims), this->nPoints());
+    for (int pos = 0; pos < this->nPoints(); ++pos)
+    {
+      ws.cs.col(pos) = c.col(strataOrder_[pos]);
+    }
+    const Matrix<T>& cs = ws.cs;
+
+    const int nStrata =
+        std::max(static_cast<int>(strataStart_.size()) - 1, 0);
+    ws.resizePartitions(nPartitions(nStrata), tileSize);
+    gb.resizePartitions(nPartitions(nStrata));
+    gb.gs.setZero(static_cast<int>(NDims), this->nPoints());
+
+    /* the samples of strata (a, b) update the gradient of the points of a
+       and b: the strata b are taken in bands, in turns, and the partitions
+       take the strata a in turns; each updates the points of its strata a in
+       place and gathers those of the band, which are added in order once
+       the band is done */
+    const int bandStrata = (nStrata + maxPartitions - 1) / maxPartitions;
+    for (int bBand = 0; bBand < nStrata; bBand += bandStrata)
+    {
+      const int bBandEnd = std::min(bBand + bandStrata, nStrata);
+      const int bandBegin = strataStart_[bBand],
+                bandSize = strataStart_[bBandEnd] - bandBegin;
+      const int nParts = nPartitions(bBandEnd);
+      parallelPartitions(bBandEnd, [&](const int p) {
+        const FlushDenormals flushDenormals;
+        Vector<T>& cDiffPow = ws.cDiffPow[p];
+        Vector<T>& dcDiffPow = ws.dcDiffPow[p];
+        Matrix<TSum>& gsBand = gb.gsPart[p];
+        int k[tileSize], l[tileSize];
+        if (gsBand.cols() < bandSize)
+        {
+          gsBand.resize(static_cast<int>(NDims), bandSize);
+        }
+        gsBand.leftCols(bandSize).setZero();
+        for (int a = p; a < bBandEnd; a += nParts)
+        {
+          for (int i = sampledStrataStart_[a]; i < sampledStrataStart_[a + 1];
+               ++i)
+          {
+            const SampledStrata& st = sampledStrata_[i];
+            if (st.b < bBand)
+            {
+              continue;
+            }
+            if (st.b >= bBandEnd)
+            {
+              break;
+            }
+            const T weight = T(st.weight);
+            for (long long t = 0; t < st.nSamples; t += tileSize)
+            {
+              const int m = static_cast<int>(
+                  std::min<long long>(tileSize, st.nSamples - t));
+              samplePairs(st, t, m, k, l);
+              for (int n = 0; n < m; ++n)
+              {
+                cDiffPow(n) =
+                    T(-0.5) * (cs.col(l[n]) - cs.col(k[n])).squaredNorm();
+              }
+              ws.sPart[p] += weight * this->underlying().partialScoreGradient(
+                                          cDiffPow.head(m), dcDiffPow.head(m));
+              for (int n = 0; n < m; ++n)
+              {
+                const Vector<TSum, NDims> gkl(
+                    (weight * dcDiffPow(n) * (cs.col(l[n]) - cs.col(k[n])))
+                        .template cast<TSum>());
+                gb.gs.col(k[n]) += gkl;
+                gsBand.col(l[n] - bandBegin) -= gkl;
+              }
+            }
+          }
+        }
+      });
+      for (int p = 0; p < nParts; ++p)
+      {
+        gb.gs.middleCols(bandBegin, bandSize) +=
+            gb.gsPart[p].leftCols(bandSize);
+      }
+    }
+    const CompensatedSum<T> s(sumPartitions(ws.sPart));
+
+    // the pairs off the diagonal appear in both orders
+    g.resize(static_cast<int>(NDims), this->nPoints());
+    for (int pos = 0; pos < this->nPoints(); ++pos)
+    {
+      g.col(strataOrder_[pos]) = TSum(2.0) * gb.gs.col(pos);
+    }
+    const T diagonalPow = T(0.0);
+    truncationError_ = T(0.0);
+    return T(2.0) * s.value() + T(this->nPoints()) *
+                            this->underlying().template partialScore<T>(
+                                Map<const Vector<T> >(&diagonalPow, 1));
+  }
+
+  template <typename U>
+  U
+  computeDualTree(const Matrix<U>& c) const
+  {
+    PairBuffers<U>& ws = pairWorkspaces_.template get<U>();
+    const KdTree<T, NDims>& tree = ws.tree;
+    ws.tree.build(c, 32);
+    tree.sort(c, ws.cs);
+    tree.centroids(ws.cs, ws.centroids);
+
+    // pairs of nodes of the first levels, evaluated in parallel
+    ws.level.clear();
+    for (int i = 0; i < tree.nNodes(); ++i)
+    {
+      const typename KdTree<T, NDims>::Node& nd = tree.node(i);
+      if (nd.depth == 6 || (nd.depth < 6 && nd.leaf()))
+      {
+        ws.level.push_back(i);
+      }
+    }
+    ws.nodePairs.clear();
+    for (std::size_t i = 0; i < ws.level.size(); ++i)
+    {
+      for (std::size_t j = i; j < ws.level.size(); ++j)
+      {
+        ws.nodePairs.emplace_back(ws.level[i], ws.level[j]);
+      }
+    }
+
+    const T tolPair = tolerance() / this->nPoints();
+    const int nNodePairs = static_cast<int>(ws.nodePairs.size());
+    const int nParts = nPartitions(nNodePairs);
+    ws.resizePartitions(nParts, 0);
+    parallelPartitions(nNodePairs, [&](const int p) {
+      for (int i = p; i < nNodePairs; i += nParts)
+      {
+        dualTree(tree, ws.cs, ws.centroids, ws.nodePairs[i].first,
+                 ws.nodePairs[i].second, tolPair, ws.cDiffPow[p], ws.sPart[p],
+                 ws.errorPart[p]);
+      }
+    });
+
+    truncationError_ = sumPartitions(ws.errorPart) / this->nPoints();
+    return this->underlying().score(sumPartitions(ws.sPart).value());
   }
 
   void
@@ -92,19 +731,299 @@ class Dispersion : public DispersionBase<Dispersion<Derived> >
     }
   }
 
+  /* strata of the sampled sums: the points, sorted by time, are split into
+     nTimeStrata blocks, whose points are sorted by their cell in a coarse grid
+     and split into nSpaceStrata strata; then the samples are shared among the
+     pairs of strata */
+  void
+  preparePoints(void)
+  {
+    strataOrder_.clear();
+    strataStart_.clear();
+    sampledStrata_.clear();
+    sampledStrataStart_.clear();
+    const int n = this->nPoints();
+    if (nSamples() == 0 || n < 2)
+    {
+      return;
+    }
+
+    const Vector<T, NDims> cMin(this->c().rowwise().minCoeff()),
+        cMax(this->c().rowwise().maxCoeff());
+    std::vector<int> cell(n);
+    for (int k = 0; k < n; ++k)
+    {
+      int i = 0;
+      for (int d = NDims - 1; d >= 0; --d)
+      {
+        const T x = (this->c()(d, k) - cMin(d)) /
+                    (cMax(d) - cMin(d) + T(1.0e-8)) * T(nSpaceStrata);
+        i = i * nSpaceStrata +
+            std::min(static_cast<int>(x), static_cast<int>(nSpaceStrata) - 1);
+      }
+      cell[k] = i;
+    }
+
+    strataOrder_.resize(n);
+    std::iota(strataOrder_.begin(), strataOrder_.end(), 0);
+    strataStart_.push_back(0);
+    for (int tb = 0; tb < nTimeStrata; ++tb)
+    {
+      const int begin = static_cast<long long>(n) * tb / nTimeStrata,
+                end = static_cast<long long>(n) * (tb + 1) / nTimeStrata;
+      std::stable_sort(strataOrder_.begin() + begin, strataOrder_.begin() + end,
+                       [&cell](const int k, const int l) {
+                         return cell[k] < cell[l];
+                       });
+      for (int sb = 1; sb <= nSpaceStrata; ++sb)
+      {
+        const int start =
+            begin + static_cast<long long>(end - begin) * sb / nSpaceStrata;
+        if (start > strataStart_.back())
+        {
+          strataStart_.push_back(start);
+        }
+      }
+    }
+
+    const int nStrata = static_cast<int>(strataStart_.size()) - 1;
+    const double nPairs = 0.5 * n * (n - 1.0);
+    long long first = 0;
+    for (int a = 0; a < nStrata; ++a)
+    {
+      sampledStrataStart_.push_back(static_cast<int>(sampledStrata_.size()));
+      for (int b = a; b < nStrata; ++b)
+      {
+        const double na = strataStart_[a + 1] - strataStart_[a],
+                     nb = strataStart_[b + 1] - strataStart_[b];
+        const double nPairsStrata = a == b ? 0.5 * na * (na - 1.0) : na * nb;
+        if (nPairsStrata == 0.0)
+        {
+          continue;
+        }
+        SampledStrata st;
+        st.a = a;
+        st.b = b;
+        st.first = first;
+        st.nSamples = std::max(
+            1LL, std::llround(nSamples() * nPairsStrata / nPairs));
+        st.weight = nPairsStrata / st.nSamples;
+        sampledStrata_.push_back(st);
+        first += st.nSamples;
+      }
+    }
+    sampledStrataStart_.push_back(static_cast<int>(sampledStrata_.size()));
+  }
+
  protected:
+  // sum of the terms of the pairs (k, l), k < l, of points of tiles i and j
+  template <typename U>
+  U
+  tilePairs(const Matrix<U, Dynamic, NDims>& ct, const int i, const int j,
+            Vector<U>& cDiffPow) const
+  {
+    const int iBegin = i * tileSize,
+              iEnd = std::min(iBegin + tileSize, this->nPoints());
+    const int jBegin = j * tileSize,
+              jEnd = std::min(jBegin + tileSize, this->nPoints());
+
+    CompensatedSum<U> s;
+    for (int k = iBegin; k < iEnd; ++k)
+    {
+      const int lBegin = i == j ? k + 1 : jBegin, m = jEnd - lBegin;
+      if (m <= 0)
+      {
+        continue;
+      }
+      tilePow(ct, k, lBegin, m, cDiffPow);
+      s += this->underlying().template partialScore<U>(cDiffPow.head(m));
+    }
+    return s.value();
+  }
+
+  /* tilePairs, and the gradient of the sum w.r.t. the points, each pair
+     counted once: that of the points of tile i is added to gt, and that of
+     the points of tile j to gtBand, whose rows start at point bandBegin; the
+     columns of tile j gather at most tileSize terms in T before they are
+     added */
+  T
+  tilePairsGradient(const Matrix<T, Dynamic, NDims>& ct, const int i,
+                    const int j, Vector<T>& cDiffPow, Vector<T>& dcDiffPow,
+                    Matrix<T, Dynamic, NDims>& gtTile,
+                    Matrix<TSum, Dynamic, NDims>& gt,
+                    Matrix<TSum, Dynamic, NDims>& gtBand,
+                    const int bandBegin) const
+  {
+    const int iBegin = i * tileSize,
+              iEnd = std::min(iBegin + tileSize, this->nPoints());
+    const int jBegin = j * tileSize,
+              jEnd = std::min(jBegin + tileSize, this->nPoints());
+
+    gtTile.topRows(jEnd - jBegin).setZero();
+    CompensatedSum<T> s;
+    for (int k = iBegin; k < iEnd; ++k)
+    {
+      const int lBegin = i == j ? k + 1 : jBegin, m = jEnd - lBegin;
+      if (m <= 0)
+      {
+        continue;
+      }
+      tilePow(ct, k, lBegin, m, cDiffPow);
+      s += this->underlying().partialScoreGradient(cDiffPow.head(m),
+                                                   dcDiffPow.head(m));
+      // the exponent of pair (k, l) grows with x_l - x_k along x_k
+      for (int d = 0; d < NDims; ++d)
+      {
+        const auto gkl =
+            dcDiffPow.head(m).array() *
+            (ct.col(d).segment(lBegin, m).array() - ct(k, d));
+        gt(k, d) += TSum(gkl.sum());
+        gtTile.col(d).segment(lBegin - jBegin, m).array() -= gkl;
+      }
+    }
+    gtBand.middleRows(jBegin - bandBegin, jEnd - jBegin) +=
+        gtTile.topRows(jEnd - jBegin).template cast<TSum>();
+    return s.value();
+  }
+
+  // exponents of the pairs of point k with points [lBegin, lBegin + m)
   template <typename U>
   void
-  pointsDiff(const int k, const Matrix<U>& p, Matrix<U>& pDiff) const
+  tilePow(const Matrix<U, Dynamic, NDims>& ct, const int k, const int lBegin,
+          const int m, Vector<U>& cDiffPow) const
+  {
+    cDiffPow.head(m) =
+        T(-0.5) * (ct.col(0).segment(lBegin, m).array() - ct(k, 0)).square();
+    for (int d = 1; d < NDims; ++d)
+    {
+      cDiffPow.head(m).array() -=
+          T(0.5) * (ct.col(d).segment(lBegin, m).array() - ct(k, d)).square();
+    }
+  }
+
+  /* sorted positions (k[n], l[n]) of samples [t, t + m) of the pairs of
+     strata st, uniform over the pairs of distinct points */
+  void
+  samplePairs(const SampledStrata& st, const long long t, const int m, int* k,
+              int* l) const
   {
-    pDiff = p.colwise() - p.col(k);
+    const std::uint64_t key = splitMix64(seed_) + st.first + t;
+    const std::uint64_t beginA = strataStart_[st.a],
+                        nA = strataStart_[st.a + 1] - beginA;
+    const std::uint64_t beginB = strataStart_[st.b],
+                        nB = strataStart_[st.b + 1] - beginB;
+    for (int n = 0; n < m; ++n)
+    {
+      const std::uint64_t r = splitMix64(key + n);
+      const std::uint64_t rA = r >> 32, rB = r & 0xffffffffULL;
+      const std::uint64_t kA = (rA * nA) >> 32;
+      k[n] = static_cast<int>(beginA + kA);
+      if (st.a == st.b)
+      {
+        // any point of the strata but k[n]
+        const std::uint64_t lA = (rB * (nA - 1)) >> 32;
+        l[n] = static_cast<int>(beginA + (lA < kA ? lA : lA + 1));
+      }
+      else
+      {
+        l[n] = static_cast<int>(beginB + ((rB * nB) >> 32));
+      }
+    }
   }
 
+  // bound on the error of the truncated sums, given the pairs evaluated
+  void
+  computeTruncationError(const long long nPairs) const
+  {
+    // every neglected pair is farther than the cutoff
+    const long long nPoints = this->nPoints();
+    truncationError_ = static_cast<T>(nPoints * nPoints - nPairs) *
+                       std::abs(pairScore(T(-0.5) * cutoff() * cutoff())) /
+                       static_cast<T>(nPoints);
+  }
+
+  // term of a pair of points, given its exponent
+  T
+  pairScore(const T& cDiffPow) const
+  {
+    return this->underlying().template partialScore<T>(
+        Map<const Vector<T> >(&cDiffPow, 1));
+  }
+
+  /* sum of the terms of the pairs of points of nodes a and b, in both orders;
+     the terms are monotonic with the distance, so they are bounded by the
+     terms at the minimum and maximum distances between the nodes */
   template <typename U>
   void
-  pointsPow(const Matrix<U>& p, Vector<U>& pPow) const
+  dualTree(const KdTree<T, NDims>& tree, const Matrix<U>& cs,
+           const Matrix<U>& centroids, const int a, const int b,
+           const T& tolPair, Vector<U>& cDiffPow, CompensatedSum<U>& s,
+           T& error) const
   {
-    pPow = T(-0.5) * p.array().square().colwise().sum();
+    const typename KdTree<T, NDims>::Node &na = tree.node(a),
+                                          &nb = tree.node(b);
+    T dMin = T(0.0), dMax = T(0.0);
+    for (int d = 0; d < NDims; ++d)
+    {
+      const T gap = std::max(
+          std::max(na.min(d) - nb.max(d), nb.min(d) - na.max(d)), T(0.0));
+      const T span = std::max(na.max(d) - nb.min(d), nb.max(d) - na.min(d));
+      dMin += gap * gap;
+      dMax += span * span;
+    }
+    const T bound =
+        std::abs(pairScore(T(-0.5) * dMin) - pairScore(T(-0.5) * dMax));
+    const T nPairs = T(na.size()) * T(nb.size()) * (a == b ? T(1.0) : T(2.0));
+
+    if (bound <= tolPair)
+    {
+      const U centroidsPow =
+          T(-0.5) * (centroids.col(a) - centroids.col(b)).squaredNorm();
+      s += nPairs * this->underlying().template partialScore<U>(
+                        Map<const Vector<U> >(&centroidsPow, 1));
+      error += nPairs * bound;
+      return;
+    }
+
+    if (na.leaf() && nb.leaf())
+    {
+      if (cDiffPow.size() < nb.size())
+      {
+        cDiffPow.resize(nb.size());
+      }
+      U sLeaf = U(0.0);
+      for (int k = na.begin; k < na.end; ++k)
+      {
+        for (int l = nb.begin, n = 0; l < nb.end; ++l, ++n)
+        {
+          cDiffPow(n) = T(-0.5) * (cs.col(l) - cs.col(k)).squaredNorm();
+        }
+        sLeaf += this->underlying().template partialScore<U>(
+            cDiffPow.head(nb.size()));
+      }
+      s += (a == b ? T(1.0) : T(2.0)) * sLeaf;
+      return;
+    }
+
+    if (a == b)
+    {
+      dualTree(tree, cs, centroids, na.left, na.left, tolPair, cDiffPow, s,
+               error);
+      dualTree(tree, cs, centroids, na.left, na.right, tolPair, cDiffPow, s,
+               error);
+      dualTree(tree, cs, centroids, na.right, na.right, tolPair, cDiffPow, s,
+               error);
+    }
+    else if (nb.leaf() || (!na.leaf() && na.size() >= nb.size()))
+    {
+      dualTree(tree, cs, centroids, na.left, b, tolPair, cDiffPow, s, error);
+      dualTree(tree, cs, centroids, na.right, b, tolPair, cDiffPow, s, error);
+    }
+    else
+    {
+      dualTree(tree, cs, centroids, a, nb.left, tolPair, cDiffPow, s, error);
+      dualTree(tree, cs, centroids, a, nb.right, tolPair, cDiffPow, s, error);
+    }
   }
 
  private:
@@ -0,0 +1,177 @@
+#ifndef EVENT_EMIN_KD_TREE_H
+#define EVENT_EMIN_KD_TREE_H
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <vector>
+
+#include "EventEMin/types_def.h"
+#include "EventEMin/utilities.h"
+
+namespace EventEMin
+{
+/* kd-tree over a set of points, split at the median of the widest dimension
+   of every node until at most leafSize points remain; the points are sorted
+   by node, so that the points of every node are contiguous */
+template <typename T, int N>
+class KdTree
+{
+ public:
+  struct Node
+  {
+    // points at sorted positions [begin, end)
+    int begin = 0, end = 0;
+    // children, -1 for leaves
+    int left = -1, right = -1;
+    int depth = 0;
+    Vector<T, N> min = Vector<T, N>::Zero(), max = Vector<T, N>::Zero();
+
+    int
+    size(void) const
+    {
+      return end - begin;
+    }
+    bool
+    leaf(void) const
+    {
+      return left < 0;
+    }
+  };
+
+ private:
+  // nodes in preorder, the root first
+  StdVector<Node> nodes_;
+  std::vector<int> order_;
+  // plain values of the points being split
+  Matrix<T> v_;
+
+ public:
+  KdTree(void) = default;
+
+  int
+  nNodes(void) const
+  {
+    return static_cast<int>(nodes_.size());
+  }
+  const Node&
+  node(const int i) const
+  {
+    assert(0 <= i && i < nNodes());
+    return nodes_[i];
+  }
+  int
+  nPoints(void) const
+  {
+    return static_cast<int>(order_.size());
+  }
+  // index of the point at a sorted position
+  int
+  order(const int pos) const
+  {
+    assert(0 <= pos && pos < nPoints());
+    return order_[pos];
+  }
+
+  template <typename U>
+  void
+  build(const Matrix<U>& c, const int leafSize)
+  {
+    assert(c.rows() == N);
+    assert(0 < leafSize);
+
+    const int n = c.cols();
+    v_.resize(N, n);
+    for (int k = 0; k < n; ++k)
+    {
+      for (int d = 0; d < N; ++d)
+      {
+        v_(d, k) = scalarValue(c(d, k));
+      }
+    }
+    order_.resize(n);
+    std::iota(order_.begin(), order_.end(), 0);
+    nodes_.clear();
+    nodes_.reserve(2 * (n / leafSize + 1));
+    if (n > 0)
+    {
+      build(v_, 0, n, 0, leafSize);
+    }
+  }
+
+  // copy of the points in sorted order
+  template <typename U>
+  void
+  sort(const Matrix<U>& c, Matrix<U>& cs) const
+  {
+    cs.resize(N, nPoints());
+    for (int pos = 0; pos < nPoints(); ++pos)
+    {
+      cs.col(pos) = c.col(order_[pos]);
+    }
+  }
+
+  // centroids of the nodes, from the points in sorted order
+  template <typename U>
+  void
+  centroids(const Matrix<U>& cs, Matrix<U>& centroids) const
+  {
+    centroids.resize(N, nNodes());
+    // children follow their parents in preorder
+    for (int i = nNodes() - 1; i >= 0; --i)
+    {
+      const Node& nd = nodes_[i];
+      if (nd.leaf())
+      {
+        centroids.col(i) = cs.middleCols(nd.begin, nd.size()).rowwise().sum() /
+                           T(nd.size());
+      }
+      else
+      {
+        centroids.col(i) =
+            (T(nodes_[nd.left].size()) * centroids.col(nd.left) +
+             T(nodes_[nd.right].size()) * centroids.col(nd.right)) /
+            T(nd.size());
+      }
+    }
+  }
+
+ private:
+  int
+  build(const Matrix<T>& v, const int begin, const int end, const int depth,
+        const int leafSize)
+  {
+    const int i = nNodes();
+    nodes_.push_back(Node());
+    Node nd;
+    nd.begin = begin;
+    nd.end = end;
+    nd.left = -1;
+    nd.right = -1;
+    nd.depth = depth;
+    nd.min = v.col(order_[begin]);
+    nd.max = nd.min;
+    for (int pos = begin + 1; pos < end; ++pos)
+    {
+      nd.min = nd.min.cwiseMin(v.col(order_[pos]));
+      nd.max = nd.max.cwiseMax(v.col(order_[pos]));
+    }
+
+    int d;
+    if (end - begin > leafSize && (nd.max - nd.min).maxCoeff(&d) > T(0.0))
+    {
+      const int middle = begin + ((end - begin) >> 1);
+      std::nth_element(order_.begin() + begin, order_.begin() + middle,
+                       order_.begin() + end, [&v, d](const int k, const int l) {
+                         return v(d, k) < v(d, l);
+                       });
+      nd.left = build(v, begin, middle, depth + 1, leafSize);
+      nd.right = build(v, middle, end, depth + 1, leafSize);
+    }
+    nodes_[i] = nd;
+    return i;
+  }
+};
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_KD_TREE_H
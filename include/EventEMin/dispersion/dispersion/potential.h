@@ -39,11 +39,20 @@ class Potential : public Dispersion<Potential<M> >
   Potential(const T& dimScale) : Dispersion<Potential<Model> >(dimScale) {}
   template <typename U>
   U
-  partialScore(const Vector<U>& cDiffPow) const
+  partialScore(const Ref<const Vector<U> >& cDiffPow) const
   {
     return cDiffPow.array().exp().sum();
   }
 
+  // partialScore, and the derivative of every term w.r.t. its exponent
+  T
+  partialScoreGradient(const Ref<const Vector<T> >& cDiffPow,
+                       Ref<Vector<T> > dcDiffPow) const
+  {
+    dcDiffPow = cDiffPow.array().exp();
+    return dcDiffPow.sum();
+  }
+
   template <typename U>
   U
   score(const U& s) const
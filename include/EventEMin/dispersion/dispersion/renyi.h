@@ -61,11 +61,22 @@ class Renyi : public Dispersion<Renyi<M> >
 
   template <typename U>
   U
-  partialScore(const Vector<U>& cDiffPow) const
+  partialScore(const Ref<const Vector<U> >& cDiffPow) const
   {
     return (alpha() * cDiffPow).array().exp().sum();
   }
 
+  // partialScore, and the derivative of every term w.r.t. its exponent
+  T
+  partialScoreGradient(const Ref<const Vector<T> >& cDiffPow,
+                       Ref<Vector<T> > dcDiffPow) const
+  {
+    dcDiffPow = (alpha() * cDiffPow).array().exp();
+    const T s = dcDiffPow.sum();
+    dcDiffPow *= alpha();
+    return s;
+  }
+
   template <typename U>
   U
   score(const U& s) const
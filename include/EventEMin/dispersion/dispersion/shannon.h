@@ -46,11 +46,22 @@ class Shannon : public Dispersion<Shannon<M> >
   }
   template <typename U>
   U
-  partialScore(const Vector<U>& cDiffPow) const
+  partialScore(const Ref<const Vector<U> >& cDiffPow) const
   {
     return (cDiffPow.array().exp() * (cDiffPow.array() - logDen_)).sum();
   }
 
+  // partialScore, and the derivative of every term w.r.t. its exponent
+  T
+  partialScoreGradient(const Ref<const Vector<T> >& cDiffPow,
+                       Ref<Vector<T> > dcDiffPow) const
+  {
+    dcDiffPow = cDiffPow.array().exp();
+    const T s = (dcDiffPow.array() * (cDiffPow.array() - logDen_)).sum();
+    dcDiffPow.array() *= cDiffPow.array() - logDen_ + T(1.0);
+    return s;
+  }
+
   template <typename U>
   U
   score(const U& s) const
@@ -4,6 +4,7 @@
 #include <cassert>
 
 #include "EventEMin/data_stats.h"
+#include "EventEMin/event/type.h"
 #include "EventEMin/types_def.h"
 #include "EventEMin/utilities.h"
 
@@ -194,6 +194,16 @@ class Dispersion
     whitening_.updateStats(varse_.vars, c, tsDiffRef, nPoints_);
   }
 
+  // runs each event of the block in order
+  void
+  run(const EventBlockRef<T, NDims>& evs)
+  {
+    for (int k = 0; k < evs.nEvents(); ++k)
+    {
+      run(evs.c.col(k), evs.ts(k));
+    }
+  }
+
   void
   setInc(const T& inc)
   {
@@ -0,0 +1,223 @@
+#ifndef EVENT_EMIN_ESTIMATE_SINK_H
+#define EVENT_EMIN_ESTIMATE_SINK_H
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EventEMin/types_def.h"
+
+namespace EventEMin
+{
+enum SINK_FORMAT
+{
+  // one "ts vars" line per estimate
+  SINK_TEXT,
+  // header followed by the raw scalars ts, vars of every estimate
+  SINK_BINARY
+};
+
+struct EstimateHeader
+{
+  char magic[8];
+  std::uint32_t scalarSize, nVars;
+};
+
+constexpr char estimateMagic[8] = {'E', 'V', 'E', 'M', 'I', 'N', 'E', '\0'};
+
+/* writes estimates from a background thread: push copies the estimate into a
+   ring buffer of nRecords records, which the writer drains in batches and
+   flushes to disk at most every flushInterval; push only waits when the ring
+   is full */
+template <typename T, int NVars>
+class EstimateSink
+{
+ private:
+  struct Record
+  {
+    T ts;
+    T vars[NVars];
+  };
+
+  std::ofstream fout_;
+  const SINK_FORMAT format_;
+  const std::chrono::milliseconds flushInterval_;
+
+  // records [tail_, head_) are pending, indexed modulo the ring size
+  std::vector<Record> ring_;
+  std::uint64_t head_, tail_, written_;
+  bool stop_, flushRequest_;
+
+  std::mutex mutex_;
+  std::condition_variable pendingCond_, writtenCond_;
+  std::thread thread_;
+
+ public:
+  EstimateSink(const std::string& fname, const SINK_FORMAT format = SINK_TEXT,
+               const int nRecords = 1024,
+               const std::chrono::milliseconds& flushInterval =
+                   std::chrono::milliseconds(100))
+      : format_(format),
+        flushInterval_(flushInterval),
+        ring_(nRecords),
+        head_(0),
+        tail_(0),
+        written_(0),
+        stop_(false),
+        flushRequest_(false)
+  {
+    assert(0 < nRecords);
+
+    fout_.open(fname.c_str(), format_ == SINK_BINARY
+                                  ? std::ios::binary | std::ios::trunc
+                                  : std::ios::trunc);
+    if (!fout_.is_open())
+    {
+      return;
+    }
+    if (format_ == SINK_BINARY)
+    {
+      EstimateHeader header;
+      std::memcpy(header.magic, estimateMagic, sizeof(estimateMagic));
+      header.scalarSize = sizeof(T);
+      header.nVars = NVars;
+      fout_.write(reinterpret_cast<const char*>(&header),
+                  sizeof(EstimateHeader));
+    }
+    thread_ = std::thread(&EstimateSink::write, this);
+  }
+  EstimateSink(const EstimateSink&) = delete;
+  EstimateSink&
+  operator=(const EstimateSink&) = delete;
+  ~EstimateSink(void)
+  {
+    if (!thread_.joinable())
+    {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    pendingCond_.notify_one();
+    thread_.join();
+  }
+
+  bool
+  isOpen(void) const
+  {
+    return fout_.is_open();
+  }
+
+  void
+  push(const T& ts, const Ref<const Vector<T, NVars> >& vars)
+  {
+    if (!isOpen())
+    {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    writtenCond_.wait(lock, [this] { return head_ - tail_ < ring_.size(); });
+    Record& record = ring_[head_ % ring_.size()];
+    record.ts = ts;
+    Map<Vector<T, NVars> >(record.vars) = vars;
+    ++head_;
+    // the writer is woken up once half of the ring is pending
+    if (head_ - tail_ == (ring_.size() + 1) / 2)
+    {
+      pendingCond_.notify_one();
+    }
+  }
+
+  // waits until every pushed estimate has been written to disk
+  void
+  flush(void)
+  {
+    if (!isOpen())
+    {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    const std::uint64_t head = head_;
+    flushRequest_ = true;
+    pendingCond_.notify_one();
+    writtenCond_.wait(lock, [this, head] { return written_ >= head; });
+  }
+
+ private:
+  void
+  write(void)
+  {
+    std::vector<Record> batch;
+    batch.reserve(ring_.size());
+    std::chrono::steady_clock::time_point lastFlush =
+        std::chrono::steady_clock::now();
+
+    for (;;)
+    {
+      bool stop, flush;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        pendingCond_.wait_for(lock, flushInterval_, [this] {
+          return stop_ || flushRequest_ ||
+                 head_ - tail_ >= (ring_.size() + 1) / 2;
+        });
+        batch.clear();
+        for (; tail_ < head_; ++tail_)
+        {
+          batch.push_back(ring_[tail_ % ring_.size()]);
+        }
+        stop = stop_;
+        flush = flushRequest_;
+        flushRequest_ = false;
+      }
+      writtenCond_.notify_all();
+
+      for (const Record& record : batch)
+      {
+        writeRecord(record);
+      }
+      const std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now();
+      if (stop || flush || now - lastFlush >= flushInterval_)
+      {
+        fout_.flush();
+        lastFlush = now;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        written_ = tail_;
+      }
+      writtenCond_.notify_all();
+      if (stop)
+      {
+        return;
+      }
+    }
+  }
+
+  void
+  writeRecord(const Record& record)
+  {
+    if (format_ == SINK_BINARY)
+    {
+      fout_.write(reinterpret_cast<const char*>(&record), sizeof(Record));
+    }
+    else
+    {
+      fout_ << record.ts << ' '
+            << Map<const Vector<T, NVars> >(record.vars).transpose() << '\n';
+    }
+  }
+};
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_ESTIMATE_SINK_H
@@ -1,11 +1,20 @@
 #ifndef EVENT_EMIN_EVENT_ALL_H
 #define EVENT_EMIN_EVENT_ALL_H
 
+#include "EventEMin/event/aedat_io.h"
+#include "EventEMin/event/archive_io.h"
+#include "EventEMin/event/binary_io.h"
 #include "EventEMin/event/conversion.h"
+#include "EventEMin/event/decoder.h"
+#include "EventEMin/event/evt_io.h"
+#include "EventEMin/event/hdf5_io.h"
+#include "EventEMin/event/index.h"
 #include "EventEMin/event/io.h"
+#include "EventEMin/event/parallel_io.h"
 #include "EventEMin/event/show.h"
 #include "EventEMin/event/transform.h"
 #include "EventEMin/event/type.h"
 #include "EventEMin/event/undistort.h"
+#include "EventEMin/event/window_reader.h"
 
 #endif  // EVENT_EMIN_EVENT_ALL_H
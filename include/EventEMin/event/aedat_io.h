@@ -0,0 +1,313 @@
+#ifndef EVENT_EMIN_EVENT_AEDAT_IO_H
+#define EVENT_EMIN_EVENT_AEDAT_IO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "EventEMin/event/decoder.h"
+#include "EventEMin/event/io.h"
+#include "EventEMin/event/type.h"
+
+namespace EventEMin
+{
+namespace flatbuffer
+{
+// read-only access to the tables of a flatbuffer, with bounds checks
+class Table
+{
+ private:
+  const char* buffer_;
+  std::size_t size_, pos_;
+
+ public:
+  Table(void) : buffer_(nullptr), size_(0), pos_(0) {}
+  Table(const char* buffer, const std::size_t size, const std::size_t pos)
+      : buffer_(buffer), size_(size), pos_(pos)
+  {
+  }
+
+  // root table of a buffer
+  static Table
+  root(const char* buffer, const std::size_t size)
+  {
+    std::uint32_t pos;
+    if (size < sizeof(pos))
+    {
+      return Table();
+    }
+    std::memcpy(&pos, buffer, sizeof(pos));
+    return Table(buffer, size, pos).valid() ? Table(buffer, size, pos)
+                                            : Table();
+  }
+
+  bool
+  isNull(void) const
+  {
+    return buffer_ == nullptr;
+  }
+
+  // position of field i, 0 if absent
+  std::size_t
+  field(const int i) const
+  {
+    if (isNull())
+    {
+      return 0;
+    }
+    std::int32_t vtableOffset;
+    std::memcpy(&vtableOffset, buffer_ + pos_, sizeof(vtableOffset));
+    const std::int64_t vtable = static_cast<std::int64_t>(pos_) - vtableOffset;
+    std::uint16_t vtableSize, offset;
+    if (vtable < 0 ||
+        !inBounds(static_cast<std::size_t>(vtable), sizeof(vtableSize)))
+    {
+      return 0;
+    }
+    std::memcpy(&vtableSize, buffer_ + vtable, sizeof(vtableSize));
+    const std::size_t entry = 4 + 2 * i;
+    if (entry + sizeof(offset) > vtableSize ||
+        !inBounds(vtable + entry, sizeof(offset)))
+    {
+      return 0;
+    }
+    std::memcpy(&offset, buffer_ + vtable + entry, sizeof(offset));
+    return offset == 0 ? 0 : pos_ + offset;
+  }
+
+  template <typename S>
+  S
+  scalar(const int i, const S& def) const
+  {
+    const std::size_t pos = field(i);
+    if (pos == 0 || !inBounds(pos, sizeof(S)))
+    {
+      return def;
+    }
+    S val;
+    std::memcpy(&val, buffer_ + pos, sizeof(S));
+    return val;
+  }
+
+  // vector (or string) of field i, as its data and number of elements
+  bool
+  vector(const int i, const std::size_t elementSize, const char*& data,
+         std::uint32_t& n) const
+  {
+    const std::size_t pos = field(i);
+    std::uint32_t offset;
+    if (pos == 0 || !inBounds(pos, sizeof(offset)))
+    {
+      return false;
+    }
+    std::memcpy(&offset, buffer_ + pos, sizeof(offset));
+    const std::size_t start = pos + offset;
+    if (!inBounds(start, sizeof(n)))
+    {
+      return false;
+    }
+    std::memcpy(&n, buffer_ + start, sizeof(n));
+    if (!inBounds(start + sizeof(n), n * elementSize))
+    {
+      return false;
+    }
+    data = buffer_ + start + sizeof(n);
+    return true;
+  }
+
+ private:
+  bool
+  inBounds(const std::size_t pos, const std::size_t n) const
+  {
+    return pos <= size_ && n <= size_ - pos;
+  }
+  bool
+  valid(void) const
+  {
+    return inBounds(pos_, sizeof(std::int32_t));
+  }
+};
+}  // namespace flatbuffer
+
+/* streaming decoder of AEDAT 4.0 recordings; only the event packets of
+   uncompressed files are decoded, the rest of the packets are skipped;
+   timestamps are relative to the first event of the file */
+template <typename T>
+class Aedat4Reader : public DecoderBase<Aedat4Reader<T>, T>
+{
+ private:
+  typedef DecoderBase<Aedat4Reader<T>, T> Base;
+  friend Base;
+
+  static constexpr char version_[] = "#!AER-DAT4.0";
+  static constexpr char eventsId_[] = "EVTS";
+  // size of a packed event: int64 t, int16 x, int16 y, bool on, padding
+  static constexpr std::size_t eventSize_ = 16;
+
+  std::int64_t dataTablePos_;
+  bool tsOriginSet_;
+  std::vector<char> packet_;
+
+ public:
+  Aedat4Reader(void) : dataTablePos_(-1), tsOriginSet_(false) {}
+  Aedat4Reader(const std::string& fname) : Aedat4Reader() { open(fname); }
+
+  IO_STATUS
+  open(const std::string& fname)
+  {
+    close();
+    this->fin_.open(fname.c_str(), std::ios::binary);
+    if (!this->fin_.is_open())
+    {
+      return IO_FAIL;
+    }
+    if (!readHeader())
+    {
+      close();
+      return IO_FAIL;
+    }
+    return this->fin_.peek() == std::char_traits<char>::eof() ? IO_EMPTY
+                                                              : IO_SUCCESS;
+  }
+
+  void
+  close(void)
+  {
+    Base::close();
+    dataTablePos_ = -1;
+    tsOriginSet_ = false;
+  }
+
+ private:
+  bool
+  readHeader(void)
+  {
+    std::string line;
+    if (!std::getline(this->fin_, line) ||
+        line.compare(0, sizeof(version_) - 1, version_) != 0)
+    {
+      return false;
+    }
+
+    std::int32_t size;
+    this->fin_.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!this->fin_ || size <= 0)
+    {
+      return false;
+    }
+    std::vector<char> header(size);
+    if (!this->fin_.read(header.data(), size))
+    {
+      return false;
+    }
+
+    // IOHeader: compression, dataTablePosition, infoNode
+    const flatbuffer::Table table(flatbuffer::Table::root(header.data(), size));
+    if (table.isNull() || table.scalar<std::int32_t>(0, 0) != 0)
+    {
+      return false;
+    }
+    dataTablePos_ = table.scalar<std::int64_t>(1, -1);
+
+    const char* info;
+    std::uint32_t n;
+    if (table.vector(2, 1, info, n))
+    {
+      const std::string infoNode(info, n);
+      this->width_ = attribute(infoNode, "sizeX");
+      this->height_ = attribute(infoNode, "sizeY");
+    }
+    return true;
+  }
+
+  // first integer attribute named key of the XML description of the streams
+  static int
+  attribute(const std::string& infoNode, const std::string& key)
+  {
+    const std::size_t pos = infoNode.find("\"" + key + "\"");
+    if (pos == std::string::npos)
+    {
+      return 0;
+    }
+    const std::size_t start = infoNode.find('>', pos);
+    int val;
+    if (start == std::string::npos ||
+        std::sscanf(infoNode.c_str() + start + 1, "%d", &val) != 1)
+    {
+      return 0;
+    }
+    return val;
+  }
+
+  bool
+  decode(void)
+  {
+    if (dataTablePos_ >= 0 && this->fin_.tellg() >= dataTablePos_)
+    {
+      return false;
+    }
+
+    // packet header: stream id, size
+    std::int32_t header[2];
+    if (!this->fin_.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[1] < 0)
+    {
+      return false;
+    }
+    packet_.resize(header[1]);
+    if (!this->fin_.read(packet_.data(), header[1]))
+    {
+      return false;
+    }
+
+    const std::size_t size = packet_.size();
+    if (size < 8 || std::memcmp(packet_.data() + 4, eventsId_, 4) != 0)
+    {
+      return true;
+    }
+    // EventPacket: elements
+    const flatbuffer::Table table(
+        flatbuffer::Table::root(packet_.data(), size));
+    const char* data;
+    std::uint32_t n;
+    if (!table.vector(0, eventSize_, data, n))
+    {
+      return true;
+    }
+    for (std::uint32_t k = 0; k < n; ++k, data += eventSize_)
+    {
+      std::int64_t t;
+      std::int16_t xy[2];
+      std::memcpy(&t, data, sizeof(t));
+      std::memcpy(xy, data + 8, sizeof(xy));
+      if (!tsOriginSet_)
+      {
+        this->tsOrigin_ = t;
+        tsOriginSet_ = true;
+      }
+      this->stage(t, xy[0], xy[1], data[12] ? 1 : -1);
+    }
+    return true;
+  }
+};
+
+template <typename T>
+IO_STATUS
+loadAedat4(const std::string& fname, EventBlock<T, 2>& evs, int& width,
+           int& height)
+{
+  Aedat4Reader<T> reader;
+  const IO_STATUS ioStatus = reader.open(fname);
+  if (ioStatus != IO_SUCCESS)
+  {
+    return ioStatus;
+  }
+  width = reader.width();
+  height = reader.height();
+  return reader.read(evs);
+}
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_EVENT_AEDAT_IO_H
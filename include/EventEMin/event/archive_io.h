@@ -0,0 +1,856 @@
+#ifndef EVENT_EMIN_EVENT_ARCHIVE_IO_H
+#define EVENT_EMIN_EVENT_ARCHIVE_IO_H
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef EventEMin_ZSTD
+#include <zstd.h>
+#endif
+#ifdef EventEMin_LZ4
+#include <lz4.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "EventEMin/event/io.h"
+#include "EventEMin/event/type.h"
+#include "EventEMin/types_def.h"
+
+namespace EventEMin
+{
+/* block-compressed layout of a sequence of events:
+   header | block 0 | ... | block nBlocks-1 | index (nBlocks entries)
+   every block holds up to nEventsBlock events and is decoded independently:
+   coordinates (uint16 if integral, raw otherwise), polarity bits and
+   variable-length timestamp deltas, compressed as a whole by the codec */
+enum ARCHIVE_CODEC
+{
+  ARCHIVE_PACKED,
+  ARCHIVE_ZSTD,
+  ARCHIVE_LZ4
+};
+
+constexpr char archiveMagic[8] = {'E', 'V', 'E', 'M', 'I', 'N', 'A', '\0'};
+constexpr std::uint32_t archiveVersion = 1;
+
+struct ArchiveHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t nDims, scalarSize;
+  std::uint32_t codec;
+  std::int32_t width, height;
+  std::uint32_t nEventsBlock, reserved;
+  std::uint64_t nEvents, nBlocks;
+  // byte offset of the index from the beginning of the file
+  std::uint64_t indexOffset;
+  // timestamps are stored as integer multiples of tsResolution seconds
+  double tsResolution;
+};
+
+struct ArchiveBlock
+{
+  std::uint64_t offset;
+  // first timestamp of the block, in multiples of tsResolution
+  std::int64_t tsFirst;
+  std::uint32_t size, rawSize, nEvents, reserved;
+};
+
+inline bool
+archiveCodecAvailable(const ARCHIVE_CODEC codec)
+{
+  switch (codec)
+  {
+    case ARCHIVE_PACKED:
+      return true;
+    case ARCHIVE_ZSTD:
+#ifdef EventEMin_ZSTD
+      return true;
+#else
+      return false;
+#endif
+    case ARCHIVE_LZ4:
+#ifdef EventEMin_LZ4
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+// best codec compiled in
+inline ARCHIVE_CODEC
+archiveDefaultCodec(void)
+{
+  if (archiveCodecAvailable(ARCHIVE_ZSTD))
+  {
+    return ARCHIVE_ZSTD;
+  }
+  if (archiveCodecAvailable(ARCHIVE_LZ4))
+  {
+    return ARCHIVE_LZ4;
+  }
+  return ARCHIVE_PACKED;
+}
+
+namespace archive
+{
+enum
+{
+  COORD_UINT16,
+  COORD_RAW
+};
+
+inline void
+putVarint(std::int64_t val, std::vector<char>& out)
+{
+  // zigzag, so that small negative deltas stay short
+  std::uint64_t u = (static_cast<std::uint64_t>(val) << 1) ^
+                    static_cast<std::uint64_t>(val >> 63);
+  while (u >= 0x80)
+  {
+    out.push_back(static_cast<char>(u | 0x80));
+    u >>= 7;
+  }
+  out.push_back(static_cast<char>(u));
+}
+
+inline bool
+getVarint(const char*& first, const char* last, std::int64_t& val)
+{
+  std::uint64_t u = 0;
+  for (int shift = 0; first < last && shift < 64; shift += 7)
+  {
+    const std::uint8_t byte = static_cast<std::uint8_t>(*first++);
+    u |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+    {
+      val = static_cast<std::int64_t>(u >> 1) ^
+            -static_cast<std::int64_t>(u & 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+std::int64_t
+ticks(const T& ts, const double tsResolution)
+{
+  return std::llround(static_cast<double>(ts) / tsResolution);
+}
+
+template <typename T, int N>
+void
+pack(const EventBlockRef<T, N>& evs, const double tsResolution,
+     std::vector<char>& raw, std::int64_t& tsFirst)
+{
+  const int n = evs.nEvents();
+  raw.clear();
+
+  std::uint8_t kind[N];
+  for (int d = 0; d < N; ++d)
+  {
+    const auto row = evs.c.row(d).array();
+    kind[d] = (row == row.floor()).all() && (row >= T(0.0)).all() &&
+                      (row <= T(65535.0)).all()
+                  ? COORD_UINT16
+                  : COORD_RAW;
+    raw.push_back(static_cast<char>(kind[d]));
+  }
+  for (int d = 0; d < N; ++d)
+  {
+    if (kind[d] == COORD_UINT16)
+    {
+      for (int k = 0; k < n; ++k)
+      {
+        const std::uint16_t x = static_cast<std::uint16_t>(evs.c(d, k));
+        raw.insert(raw.end(), reinterpret_cast<const char*>(&x),
+                   reinterpret_cast<const char*>(&x) + sizeof(x));
+      }
+    }
+    else
+    {
+      for (int k = 0; k < n; ++k)
+      {
+        const T x = evs.c(d, k);
+        raw.insert(raw.end(), reinterpret_cast<const char*>(&x),
+                   reinterpret_cast<const char*>(&x) + sizeof(x));
+      }
+    }
+  }
+
+  const std::size_t bits = raw.size();
+  raw.resize(bits + ((n + 7) >> 3), 0);
+  for (int k = 0; k < n; ++k)
+  {
+    if (evs.polarity(k) > 0)
+    {
+      raw[bits + (k >> 3)] |= static_cast<char>(1 << (k & 7));
+    }
+  }
+
+  tsFirst = ticks(evs.ts(0), tsResolution);
+  std::int64_t tsPrev = tsFirst;
+  for (int k = 1; k < n; ++k)
+  {
+    const std::int64_t ts = ticks(evs.ts(k), tsResolution);
+    putVarint(ts - tsPrev, raw);
+    tsPrev = ts;
+  }
+}
+
+// decodes a block of n events into c (N x n, column-major), ts and polarity
+template <typename T, int N>
+bool
+unpack(const char* first, const char* last, const int n,
+       const std::int64_t tsFirst, const double tsResolution, T* c, T* ts,
+       int* polarity)
+{
+  if (last - first < N)
+  {
+    return false;
+  }
+  std::uint8_t kind[N];
+  for (int d = 0; d < N; ++d)
+  {
+    kind[d] = static_cast<std::uint8_t>(*first++);
+  }
+  for (int d = 0; d < N; ++d)
+  {
+    const std::size_t size =
+        kind[d] == COORD_UINT16 ? sizeof(std::uint16_t) : sizeof(T);
+    if (static_cast<std::size_t>(last - first) < n * size)
+    {
+      return false;
+    }
+    for (int k = 0; k < n; ++k, first += size)
+    {
+      if (kind[d] == COORD_UINT16)
+      {
+        std::uint16_t x;
+        std::memcpy(&x, first, sizeof(x));
+        c[N * k + d] = static_cast<T>(x);
+      }
+      else
+      {
+        std::memcpy(c + N * k + d, first, sizeof(T));
+      }
+    }
+  }
+
+  if (last - first < ((n + 7) >> 3))
+  {
+    return false;
+  }
+  for (int k = 0; k < n; ++k)
+  {
+    polarity[k] = (first[k >> 3] >> (k & 7)) & 1 ? 1 : -1;
+  }
+  first += (n + 7) >> 3;
+
+  std::int64_t t = tsFirst;
+  ts[0] = static_cast<T>(static_cast<double>(t) * tsResolution);
+  for (int k = 1; k < n; ++k)
+  {
+    std::int64_t delta;
+    if (!getVarint(first, last, delta))
+    {
+      return false;
+    }
+    t += delta;
+    ts[k] = static_cast<T>(static_cast<double>(t) * tsResolution);
+  }
+  return true;
+}
+
+inline bool
+compress(const ARCHIVE_CODEC codec, const std::vector<char>& raw,
+         std::vector<char>& out)
+{
+  switch (codec)
+  {
+    case ARCHIVE_PACKED:
+      out = raw;
+      return true;
+#ifdef EventEMin_ZSTD
+    case ARCHIVE_ZSTD:
+    {
+      out.resize(ZSTD_compressBound(raw.size()));
+      const std::size_t size =
+          ZSTD_compress(out.data(), out.size(), raw.data(), raw.size(), 3);
+      if (ZSTD_isError(size))
+      {
+        return false;
+      }
+      out.resize(size);
+      return true;
+    }
+#endif
+#ifdef EventEMin_LZ4
+    case ARCHIVE_LZ4:
+    {
+      out.resize(LZ4_compressBound(static_cast<int>(raw.size())));
+      const int size = LZ4_compress_default(
+          raw.data(), out.data(), static_cast<int>(raw.size()),
+          static_cast<int>(out.size()));
+      if (size <= 0)
+      {
+        return false;
+      }
+      out.resize(size);
+      return true;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+inline bool
+decompress(const ARCHIVE_CODEC codec, const char* data, const std::size_t size,
+           const std::size_t rawSize, std::vector<char>& raw)
+{
+  raw.resize(rawSize);
+  switch (codec)
+  {
+    case ARCHIVE_PACKED:
+      if (size != rawSize)
+      {
+        return false;
+      }
+      std::memcpy(raw.data(), data, size);
+      return true;
+#ifdef EventEMin_ZSTD
+    case ARCHIVE_ZSTD:
+      return ZSTD_decompress(raw.data(), rawSize, data, size) == rawSize;
+#endif
+#ifdef EventEMin_LZ4
+    case ARCHIVE_LZ4:
+      return LZ4_decompress_safe(data, raw.data(), static_cast<int>(size),
+                                 static_cast<int>(rawSize)) ==
+             static_cast<int>(rawSize);
+#endif
+    default:
+      return false;
+  }
+}
+}  // namespace archive
+
+/* writes events to an archive, packing and compressing several blocks in
+   parallel once enough events are pending */
+template <typename T, int N>
+class ArchiveWriter
+{
+ private:
+  std::ofstream fout_;
+  ArchiveHeader header_;
+  std::vector<ArchiveBlock> index_;
+
+  // pending events, up to one block per thread
+  EventBlock<T, N> pending_;
+  int nPending_;
+
+ public:
+  ArchiveWriter(void) : nPending_(0)
+  {
+    std::memset(&header_, 0, sizeof(ArchiveHeader));
+  }
+  ArchiveWriter(const ArchiveWriter&) = delete;
+  ArchiveWriter&
+  operator=(const ArchiveWriter&) = delete;
+  ~ArchiveWriter(void) { close(); }
+
+  bool
+  isOpen(void) const
+  {
+    return fout_.is_open();
+  }
+
+  IO_STATUS
+  open(const std::string& fname, const int width = 0, const int height = 0,
+       const ARCHIVE_CODEC codec = archiveDefaultCodec(),
+       const int nEventsBlock = 1 << 16, const double tsResolution = 1.0e-9)
+  {
+    assert(0 < nEventsBlock);
+    assert(0.0 < tsResolution);
+
+    close();
+    if (!archiveCodecAvailable(codec))
+    {
+      return IO_FAIL;
+    }
+    fout_.open(fname.c_str(), std::ios::binary | std::ios::trunc);
+    if (!fout_.is_open())
+    {
+      return IO_FAIL;
+    }
+
+    std::memset(&header_, 0, sizeof(ArchiveHeader));
+    std::memcpy(header_.magic, archiveMagic, sizeof(archiveMagic));
+    header_.version = archiveVersion;
+    header_.nDims = N;
+    header_.scalarSize = sizeof(T);
+    header_.codec = codec;
+    header_.width = width;
+    header_.height = height;
+    header_.nEventsBlock = nEventsBlock;
+    header_.tsResolution = tsResolution;
+    fout_.write(reinterpret_cast<const char*>(&header_), sizeof(ArchiveHeader));
+
+#ifdef _OPENMP
+    const int nThreads = omp_get_max_threads();
+#else
+    const int nThreads = 1;
+#endif
+    pending_.resize(nEventsBlock * nThreads);
+    nPending_ = 0;
+    index_.clear();
+
+    return fout_.good() ? IO_SUCCESS : IO_FAIL;
+  }
+
+  IO_STATUS
+  write(const EventBlockRef<T, N>& evs)
+  {
+    if (!isOpen())
+    {
+      return IO_FAIL;
+    }
+    int k = 0;
+    while (k < evs.nEvents())
+    {
+      const int n = std::min(evs.nEvents() - k, pending_.nEvents() - nPending_);
+      pending_.c.middleCols(nPending_, n) = evs.c.middleCols(k, n);
+      pending_.ts.segment(nPending_, n) = evs.ts.segment(k, n);
+      pending_.polarity.segment(nPending_, n) = evs.polarity.segment(k, n);
+      nPending_ += n;
+      k += n;
+      if (nPending_ == pending_.nEvents() && !flush())
+      {
+        return IO_FAIL;
+      }
+    }
+    return IO_SUCCESS;
+  }
+
+  IO_STATUS
+  close(void)
+  {
+    if (!isOpen())
+    {
+      return IO_FAIL;
+    }
+    bool good = flush();
+
+    header_.nBlocks = index_.size();
+    header_.indexOffset = fout_.tellp();
+    fout_.write(reinterpret_cast<const char*>(index_.data()),
+                index_.size() * sizeof(ArchiveBlock));
+    fout_.seekp(0);
+    fout_.write(reinterpret_cast<const char*>(&header_), sizeof(ArchiveHeader));
+    good = good && fout_.good();
+    fout_.close();
+    index_.clear();
+    pending_.clear();
+    nPending_ = 0;
+
+    if (!good)
+    {
+      return IO_FAIL;
+    }
+    return header_.nEvents > 0 ? IO_SUCCESS : IO_EMPTY;
+  }
+
+ private:
+  // packs and compresses the pending events, one block per thread
+  bool
+  flush(void)
+  {
+    const int nEventsBlock = header_.nEventsBlock;
+    const int nBlocks = (nPending_ + nEventsBlock - 1) / nEventsBlock;
+    std::vector<std::vector<char> > data(nBlocks);
+    std::vector<ArchiveBlock> blocks(nBlocks);
+    int nFailed = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(+ : nFailed)
+#endif
+    {
+      std::vector<char> raw;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for (int b = 0; b < nBlocks; ++b)
+      {
+        const int start = b * nEventsBlock;
+        const int n = std::min(nEventsBlock, nPending_ - start);
+        archive::pack<T, N>(pending_.slice(start, n), header_.tsResolution,
+                            raw, blocks[b].tsFirst);
+        blocks[b].rawSize = raw.size();
+        blocks[b].nEvents = n;
+        blocks[b].reserved = 0;
+        if (!archive::compress(static_cast<ARCHIVE_CODEC>(header_.codec), raw,
+                               data[b]))
+        {
+          ++nFailed;
+        }
+        blocks[b].size = data[b].size();
+      }
+    }
+    if (nFailed > 0)
+    {
+      return false;
+    }
+
+    for (int b = 0; b < nBlocks; ++b)
+    {
+      blocks[b].offset = fout_.tellp();
+      fout_.write(data[b].data(), data[b].size());
+      index_.push_back(blocks[b]);
+      header_.nEvents += blocks[b].nEvents;
+    }
+    nPending_ = 0;
+    return fout_.good();
+  }
+};
+
+/* streaming reader of an archive, decoding a batch of blocks in parallel
+   whenever the decoded events run out */
+template <typename T, int N>
+class ArchiveReader
+{
+ private:
+  std::ifstream fin_;
+  ArchiveHeader header_;
+  std::vector<ArchiveBlock> index_;
+
+  // decoded events of blocks [..., nextBlock_)
+  EventBlock<T, N> staged_;
+  int nextBlock_, next_;
+
+ public:
+  ArchiveReader(void) : nextBlock_(0), next_(0)
+  {
+    std::memset(&header_, 0, sizeof(ArchiveHeader));
+  }
+  ArchiveReader(const std::string& fname) : ArchiveReader() { open(fname); }
+
+  bool
+  isOpen(void) const
+  {
+    return fin_.is_open();
+  }
+  std::uint64_t
+  nEvents(void) const
+  {
+    return header_.nEvents;
+  }
+  int
+  nBlocks(void) const
+  {
+    return static_cast<int>(index_.size());
+  }
+  int
+  width(void) const
+  {
+    return header_.width;
+  }
+  int
+  height(void) const
+  {
+    return header_.height;
+  }
+  ARCHIVE_CODEC
+  codec(void) const
+  {
+    return static_cast<ARCHIVE_CODEC>(header_.codec);
+  }
+
+  IO_STATUS
+  open(const std::string& fname)
+  {
+    close();
+    fin_.open(fname.c_str(), std::ios::binary);
+    if (!fin_.is_open())
+    {
+      return IO_FAIL;
+    }
+    fin_.read(reinterpret_cast<char*>(&header_), sizeof(ArchiveHeader));
+    if (!fin_ ||
+        std::memcmp(header_.magic, archiveMagic, sizeof(archiveMagic)) != 0 ||
+        header_.version != archiveVersion || header_.nDims != N ||
+        header_.scalarSize != sizeof(T) ||
+        !archiveCodecAvailable(static_cast<ARCHIVE_CODEC>(header_.codec)))
+    {
+      close();
+      return IO_FAIL;
+    }
+    index_.resize(header_.nBlocks);
+    fin_.seekg(header_.indexOffset);
+    fin_.read(reinterpret_cast<char*>(index_.data()),
+              index_.size() * sizeof(ArchiveBlock));
+    if (!fin_)
+    {
+      close();
+      return IO_FAIL;
+    }
+    return nEvents() > 0 ? IO_SUCCESS : IO_EMPTY;
+  }
+
+  void
+  close(void)
+  {
+    if (fin_.is_open())
+    {
+      fin_.close();
+    }
+    std::memset(&header_, 0, sizeof(ArchiveHeader));
+    index_.clear();
+    staged_.clear();
+    nextBlock_ = 0;
+    next_ = 0;
+  }
+
+  /* positions the reader at the first event at or after ts: the search
+     starts one block before the first one that begins at or after ts, since
+     the events at ts may end the previous block */
+  IO_STATUS
+  seek(const T& ts)
+  {
+    const std::int64_t t = archive::ticks(ts, header_.tsResolution);
+    const int b = static_cast<int>(
+        std::lower_bound(index_.begin(), index_.end(), t,
+                         [](const ArchiveBlock& block, const std::int64_t t) {
+                           return block.tsFirst < t;
+                         }) -
+        index_.begin());
+    nextBlock_ = std::max(b - 1, 0);
+    staged_.clear();
+    next_ = 0;
+
+    for (;;)
+    {
+      if (next_ == staged_.nEvents() && !decode())
+      {
+        return IO_EMPTY;
+      }
+      const T* first = staged_.ts.data() + next_;
+      const T* last = staged_.ts.data() + staged_.nEvents();
+      next_ += static_cast<int>(std::lower_bound(first, last, ts) - first);
+      if (next_ < staged_.nEvents())
+      {
+        return IO_SUCCESS;
+      }
+    }
+  }
+
+  // reads the next nEvents events
+  IO_STATUS
+  read(const int nEvents, EventBlock<T, N>& evs)
+  {
+    evs.weights.resize(0);
+    evs.resize(nEvents);
+
+    int n = 0;
+    while (n < nEvents)
+    {
+      if (next_ == staged_.nEvents() && !decode())
+      {
+        break;
+      }
+      const int m = std::min(nEvents - n, staged_.nEvents() - next_);
+      evs.c.middleCols(n, m) = staged_.c.middleCols(next_, m);
+      evs.ts.segment(n, m) = staged_.ts.segment(next_, m);
+      evs.polarity.segment(n, m) = staged_.polarity.segment(next_, m);
+      next_ += m;
+      n += m;
+    }
+
+    if (n == nEvents)
+    {
+      return IO_SUCCESS;
+    }
+    evs.conservativeResize(n);
+    return n > 0 ? IO_LESS : IO_EMPTY;
+  }
+
+  // reads all the events, decoding every block in parallel
+  IO_STATUS
+  read(EventBlock<T, N>& evs)
+  {
+    nextBlock_ = 0;
+    staged_.clear();
+    next_ = 0;
+    if (!decode(nBlocks(), evs))
+    {
+      evs.clear();
+      return IO_FAIL;
+    }
+    return evs.empty() ? IO_EMPTY : IO_SUCCESS;
+  }
+
+ private:
+  bool
+  decode(void)
+  {
+#ifdef _OPENMP
+    const int nThreads = omp_get_max_threads();
+#else
+    const int nThreads = 1;
+#endif
+    next_ = 0;
+    return decode(nThreads, staged_) && staged_.nEvents() > 0;
+  }
+
+  // decodes the next nBlocksMax blocks into evs
+  bool
+  decode(const int nBlocksMax, EventBlock<T, N>& evs)
+  {
+    const int first = nextBlock_;
+    const int nBlocks = std::min(nBlocksMax, this->nBlocks() - first);
+    if (nBlocks <= 0)
+    {
+      evs.resize(0);
+      return true;
+    }
+
+    // the blocks are contiguous, so they are read at once
+    std::vector<int> start(nBlocks + 1, 0);
+    for (int b = 0; b < nBlocks; ++b)
+    {
+      start[b + 1] = start[b] + index_[first + b].nEvents;
+    }
+    const ArchiveBlock& last = index_[first + nBlocks - 1];
+    const std::uint64_t offset = index_[first].offset;
+    std::vector<char> data(last.offset + last.size - offset);
+    fin_.clear();
+    fin_.seekg(offset);
+    if (!fin_.read(data.data(), data.size()))
+    {
+      return false;
+    }
+
+    evs.weights.resize(0);
+    evs.resize(start[nBlocks]);
+    const ARCHIVE_CODEC codec = this->codec();
+    int nFailed = 0;
+#ifdef _OPENMP
+#pragma omp parallel reduction(+ : nFailed)
+#endif
+    {
+      std::vector<char> raw;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for (int b = 0; b < nBlocks; ++b)
+      {
+        const ArchiveBlock& block = index_[first + b];
+        const int k = start[b];
+        if (!archive::decompress(codec, data.data() + block.offset - offset,
+                                 block.size, block.rawSize, raw) ||
+            !archive::unpack<T, N>(raw.data(), raw.data() + raw.size(),
+                                   block.nEvents, block.tsFirst,
+                                   header_.tsResolution,
+                                   evs.c.data() + N * k, evs.ts.data() + k,
+                                   evs.polarity.data() + k))
+        {
+          ++nFailed;
+        }
+      }
+    }
+    nextBlock_ += nBlocks;
+    return nFailed == 0;
+  }
+};
+
+template <typename T, int N>
+IO_STATUS
+saveArchive(const std::string& fname, const EventBlockRef<T, N>& evs,
+            const int width = 0, const int height = 0,
+            const ARCHIVE_CODEC codec = archiveDefaultCodec())
+{
+  ArchiveWriter<T, N> writer;
+  IO_STATUS ioStatus = writer.open(fname, width, height, codec);
+  if (ioStatus != IO_SUCCESS)
+  {
+    return ioStatus;
+  }
+  ioStatus = writer.write(evs);
+  const IO_STATUS closeStatus = writer.close();
+  return ioStatus == IO_SUCCESS ? closeStatus : ioStatus;
+}
+
+template <typename T, int N>
+IO_STATUS
+loadArchive(const std::string& fname, EventBlock<T, N>& evs, int& width,
+            int& height)
+{
+  ArchiveReader<T, N> reader;
+  const IO_STATUS ioStatus = reader.open(fname);
+  if (ioStatus != IO_SUCCESS)
+  {
+    return ioStatus;
+  }
+  width = reader.width();
+  height = reader.height();
+  return reader.read(evs);
+}
+
+template <typename T, int N>
+IO_STATUS
+text2archive(const std::string& fnameIn, const std::string& fnameOut,
+             const int width = 0, const int height = 0,
+             const ARCHIVE_CODEC codec = archiveDefaultCodec(),
+             const int nEventsChunk = 1 << 16)
+{
+  std::ifstream fin(fnameIn.c_str());
+  if (!fin.is_open())
+  {
+    return IO_FAIL;
+  }
+  ArchiveWriter<T, N> writer;
+  IO_STATUS ioStatus = writer.open(fnameOut, width, height, codec);
+  if (ioStatus != IO_SUCCESS)
+  {
+    return ioStatus;
+  }
+
+  EventBlock<T, N> evs(nEventsChunk);
+  Event<T, N> ev;
+  for (;;)
+  {
+    int n = 0;
+    while (n < nEventsChunk && load<T, N>(fin, ev) == IO_SUCCESS &&
+           !fin.fail())
+    {
+      evs.c.col(n) = ev.c;
+      evs.ts(n) = ev.ts;
+      evs.polarity(n) = ev.polarity;
+      ++n;
+    }
+    if (n > 0 && writer.write(evs.slice(0, n)) != IO_SUCCESS)
+    {
+      writer.close();
+      return IO_FAIL;
+    }
+    if (n < nEventsChunk)
+    {
+      break;
+    }
+  }
+  return writer.close();
+}
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_EVENT_ARCHIVE_IO_H
@@ -0,0 +1,474 @@
+#ifndef EVENT_EMIN_EVENT_BINARY_IO_H
+#define EVENT_EMIN_EVENT_BINARY_IO_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "EventEMin/event/io.h"
+#include "EventEMin/event/type.h"
+#include "EventEMin/types_def.h"
+
+namespace EventEMin
+{
+/* binary columnar layout of a sequence of events:
+   header | ts (nEvents x T) | c (N x nEvents x T) | polarity (nEvents x int)
+   every column starts at a multiple of binaryAlignment bytes, and c is stored
+   column-major so that any window maps directly onto a Matrix<T> */
+constexpr char binaryMagic[8] = {'E', 'V', 'E', 'M', 'I', 'N', 'B', '\0'};
+constexpr std::uint32_t binaryVersion = 1;
+constexpr std::uint64_t binaryAlignment = 64;
+
+struct BinaryHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  // number of dimensions of the coordinates and size of the scalar type
+  std::uint32_t nDims, scalarSize;
+  // resolution of the sensor (0 if unknown)
+  std::int32_t width, height;
+  std::uint64_t nEvents;
+  // byte offsets of the columns from the beginning of the file
+  std::uint64_t tsOffset, cOffset, polarityOffset;
+  std::uint64_t size;
+};
+
+inline std::uint64_t
+binaryAlign(const std::uint64_t offset)
+{
+  return (offset + binaryAlignment - 1) & ~(binaryAlignment - 1);
+}
+
+template <typename T, int N>
+BinaryHeader
+binaryHeader(const std::uint64_t nEvents, const int width, const int height)
+{
+  BinaryHeader header;
+  std::memset(&header, 0, sizeof(BinaryHeader));
+  std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+  header.version = binaryVersion;
+  header.nDims = N;
+  header.scalarSize = sizeof(T);
+  header.width = width;
+  header.height = height;
+  header.nEvents = nEvents;
+  header.tsOffset = binaryAlign(sizeof(BinaryHeader));
+  header.cOffset = binaryAlign(header.tsOffset + nEvents * sizeof(T));
+  header.polarityOffset = binaryAlign(header.cOffset + N * nEvents * sizeof(T));
+  header.size = header.polarityOffset + nEvents * sizeof(std::int32_t);
+  return header;
+}
+
+/* the header must describe the layout binaryHeader produces for its number
+   of events, and every column must lie within the file */
+template <typename T, int N>
+bool
+binaryHeaderValid(const BinaryHeader& header, const std::uint64_t fsize)
+{
+  if (std::memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0 ||
+      header.version != binaryVersion || header.nDims != N ||
+      header.scalarSize != sizeof(T))
+  {
+    return false;
+  }
+  // bounds nEvents so that the offsets below cannot overflow
+  constexpr std::uint64_t eventSize =
+      (N + 1) * sizeof(T) + sizeof(std::int32_t);
+  if (header.nEvents > fsize / eventSize)
+  {
+    return false;
+  }
+  const BinaryHeader expected(
+      binaryHeader<T, N>(header.nEvents, header.width, header.height));
+  const std::uint64_t nEvents = header.nEvents;
+  return header.tsOffset == expected.tsOffset &&
+         header.cOffset == expected.cOffset &&
+         header.polarityOffset == expected.polarityOffset &&
+         header.size == expected.size &&
+         header.tsOffset + nEvents * sizeof(T) <= fsize &&
+         header.cOffset + N * nEvents * sizeof(T) <= fsize &&
+         header.polarityOffset + nEvents * sizeof(std::int32_t) <= fsize &&
+         header.size <= fsize;
+}
+
+// moves nBytes of a file to a lower offset, in chunks
+inline void
+binaryMoveDown(std::fstream& f, const std::uint64_t from,
+               const std::uint64_t to, const std::uint64_t nBytes)
+{
+  assert(to <= from);
+  constexpr std::uint64_t bufferSize = 1 << 20;
+  std::vector<char> buffer(bufferSize);
+  for (std::uint64_t i = 0; i < nBytes && to < from; i += bufferSize)
+  {
+    const std::uint64_t n = std::min(bufferSize, nBytes - i);
+    f.seekg(from + i);
+    f.read(buffer.data(), n);
+    f.seekp(to + i);
+    f.write(buffer.data(), n);
+  }
+}
+
+// counts the number of events (non-empty lines) of a text file
+inline std::uint64_t
+countEvents(std::ifstream& fin)
+{
+  constexpr std::streamsize bufferSize = 1 << 20;
+  std::vector<char> buffer(bufferSize);
+  std::uint64_t nEvents = 0;
+  char prev = '\n';
+  while (fin.read(buffer.data(), bufferSize) || fin.gcount() > 0)
+  {
+    const std::streamsize n = fin.gcount();
+    for (std::streamsize i = 0; i < n; ++i)
+    {
+      if (buffer[i] == '\n' && prev != '\n')
+      {
+        ++nEvents;
+      }
+      prev = buffer[i];
+    }
+  }
+  if (prev != '\n')
+  {
+    ++nEvents;
+  }
+  fin.clear();
+  fin.seekg(0);
+  return nEvents;
+}
+
+template <typename T, int N>
+IO_STATUS
+text2binary(const std::string& fnameIn, const std::string& fnameOut,
+            const int width = 0, const int height = 0,
+            const int nEventsChunk = 1 << 16)
+{
+  std::ifstream fin(fnameIn.c_str());
+  if (!fin.is_open())
+  {
+    return IO_FAIL;
+  }
+  const std::uint64_t nEvents = countEvents(fin);
+  if (nEvents == 0)
+  {
+    return IO_EMPTY;
+  }
+
+  std::fstream fout(fnameOut.c_str(), std::ios::in | std::ios::out |
+                                          std::ios::binary | std::ios::trunc);
+  if (!fout.is_open())
+  {
+    return IO_FAIL;
+  }
+
+  BinaryHeader header(binaryHeader<T, N>(nEvents, width, height));
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+
+  // each column is written in chunks at its own offset
+  Matrix<T> c(N, nEventsChunk);
+  Vector<T> ts(nEventsChunk);
+  Vector<std::int32_t> polarity(nEventsChunk);
+  std::uint64_t k = 0;
+  while (k < nEvents)
+  {
+    int n = 0;
+    Event<T, N> ev;
+    while (n < nEventsChunk && k + n < nEvents &&
+           load<T, N>(fin, ev) == IO_SUCCESS && !fin.fail())
+    {
+      c.col(n) = ev.c;
+      ts(n) = ev.ts;
+      polarity(n) = ev.polarity;
+      ++n;
+    }
+    if (n == 0)
+    {
+      break;
+    }
+
+    fout.seekp(header.tsOffset + k * sizeof(T));
+    fout.write(reinterpret_cast<const char*>(ts.data()), n * sizeof(T));
+    fout.seekp(header.cOffset + k * N * sizeof(T));
+    fout.write(reinterpret_cast<const char*>(c.data()), N * n * sizeof(T));
+    fout.seekp(header.polarityOffset + k * sizeof(std::int32_t));
+    fout.write(reinterpret_cast<const char*>(polarity.data()),
+               n * sizeof(std::int32_t));
+    k += n;
+  }
+
+  if (k < nEvents)
+  {
+    /* fewer events parsed than lines counted: the columns are moved down to
+       the layout of k events and the file is cut to its size */
+    const BinaryHeader packed(binaryHeader<T, N>(k, width, height));
+    binaryMoveDown(fout, header.cOffset, packed.cOffset, N * k * sizeof(T));
+    binaryMoveDown(fout, header.polarityOffset, packed.polarityOffset,
+                   k * sizeof(std::int32_t));
+    fout.seekp(0);
+    fout.write(reinterpret_cast<const char*>(&packed), sizeof(BinaryHeader));
+    const bool good = fout.good();
+    fout.close();
+    if (!good || ::truncate(fnameOut.c_str(), packed.size) != 0)
+    {
+      return IO_FAIL;
+    }
+    return k > 0 ? IO_LESS : IO_EMPTY;
+  }
+  return fout.good() ? IO_SUCCESS : IO_FAIL;
+}
+
+template <typename T, int N>
+IO_STATUS
+saveBinary(const std::string& fname, const Ref<const Matrix<T> >& c,
+           const Ref<const Vector<T> >& ts,
+           const Ref<const Vector<int> >& polarity, const int width = 0,
+           const int height = 0)
+{
+  const std::uint64_t nEvents = c.cols();
+  assert(c.rows() == N);
+  assert(ts.size() == static_cast<Index>(nEvents));
+  assert(polarity.size() == static_cast<Index>(nEvents));
+
+  if (nEvents == 0)
+  {
+    return IO_EMPTY;
+  }
+
+  std::ofstream fout(fname.c_str(), std::ios::binary | std::ios::trunc);
+  if (!fout.is_open())
+  {
+    return IO_FAIL;
+  }
+
+  const BinaryHeader header(binaryHeader<T, N>(nEvents, width, height));
+  const Vector<std::int32_t> polarity32(polarity.template cast<std::int32_t>());
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+  fout.seekp(header.tsOffset);
+  fout.write(reinterpret_cast<const char*>(ts.data()), nEvents * sizeof(T));
+  fout.seekp(header.cOffset);
+  fout.write(reinterpret_cast<const char*>(c.data()), N * nEvents * sizeof(T));
+  fout.seekp(header.polarityOffset);
+  fout.write(reinterpret_cast<const char*>(polarity32.data()),
+             nEvents * sizeof(std::int32_t));
+
+  return fout.good() ? IO_SUCCESS : IO_FAIL;
+}
+
+// read-only memory-mapped view of a binary events file
+template <typename T, int N>
+class MappedEvents
+{
+ private:
+  int fd_;
+  void* addr_;
+  std::size_t size_;
+
+  BinaryHeader header_;
+
+  const T* ts_;
+  const T* c_;
+  const int* polarity_;
+
+ public:
+  MappedEvents(void)
+      : fd_(-1),
+        addr_(MAP_FAILED),
+        size_(0),
+        ts_(nullptr),
+        c_(nullptr),
+        polarity_(nullptr)
+  {
+    static_assert(sizeof(int) == sizeof(std::int32_t),
+                  "polarity is stored as 32-bit integers");
+    std::memset(&header_, 0, sizeof(BinaryHeader));
+  }
+  MappedEvents(const MappedEvents&) = delete;
+  MappedEvents&
+  operator=(const MappedEvents&) = delete;
+  ~MappedEvents(void) { close(); }
+
+  bool
+  isOpen(void) const
+  {
+    return addr_ != MAP_FAILED;
+  }
+  int
+  nEvents(void) const
+  {
+    return static_cast<int>(header_.nEvents);
+  }
+  int
+  width(void) const
+  {
+    return header_.width;
+  }
+  int
+  height(void) const
+  {
+    return header_.height;
+  }
+
+  Map<const Matrix<T> >
+  c(void) const
+  {
+    return c(0, nEvents());
+  }
+  Map<const Matrix<T> >
+  c(const int start, const int n) const
+  {
+    assert(0 <= start && 0 <= n && start + n <= nEvents());
+    return Map<const Matrix<T> >(c_ + static_cast<std::size_t>(N) * start, N,
+                                 n);
+  }
+  Map<const Vector<T> >
+  ts(void) const
+  {
+    return ts(0, nEvents());
+  }
+  Map<const Vector<T> >
+  ts(const int start, const int n) const
+  {
+    assert(0 <= start && 0 <= n && start + n <= nEvents());
+    return Map<const Vector<T> >(ts_ + start, n);
+  }
+  T
+  ts(const int k) const
+  {
+    assert(0 <= k && k < nEvents());
+    return ts_[k];
+  }
+  Map<const Vector<int> >
+  polarity(void) const
+  {
+    return polarity(0, nEvents());
+  }
+  Map<const Vector<int> >
+  polarity(const int start, const int n) const
+  {
+    assert(0 <= start && 0 <= n && start + n <= nEvents());
+    return Map<const Vector<int> >(polarity_ + start, n);
+  }
+
+  EventBlockRef<T, N>
+  block(void) const
+  {
+    return block(0, nEvents());
+  }
+  EventBlockRef<T, N>
+  block(const int start, const int n) const
+  {
+    assert(0 <= start && 0 <= n && start + n <= nEvents());
+    return EventBlockRef<T, N>(c_ + static_cast<std::size_t>(N) * start,
+                               ts_ + start, polarity_ + start, nullptr, n);
+  }
+
+  // index of the first event at or after ts, the column is sorted by time
+  int
+  find(const T& ts) const
+  {
+    return static_cast<int>(std::lower_bound(ts_, ts_ + nEvents(), ts) - ts_);
+  }
+
+  IO_STATUS
+  open(const std::string& fname)
+  {
+    close();
+
+    fd_ = ::open(fname.c_str(), O_RDONLY);
+    if (fd_ < 0)
+    {
+      return IO_FAIL;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0 ||
+        static_cast<std::size_t>(st.st_size) < sizeof(BinaryHeader))
+    {
+      close();
+      return IO_FAIL;
+    }
+    size_ = st.st_size;
+
+    addr_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (addr_ == MAP_FAILED)
+    {
+      close();
+      return IO_FAIL;
+    }
+    std::memcpy(&header_, addr_, sizeof(BinaryHeader));
+    if (!binaryHeaderValid<T, N>(header_, size_))
+    {
+      close();
+      return IO_FAIL;
+    }
+    // events are usually read front to back
+    madvise(addr_, size_, MADV_SEQUENTIAL);
+
+    const char* base = static_cast<const char*>(addr_);
+    ts_ = reinterpret_cast<const T*>(base + header_.tsOffset);
+    c_ = reinterpret_cast<const T*>(base + header_.cOffset);
+    polarity_ = reinterpret_cast<const int*>(base + header_.polarityOffset);
+
+    return nEvents() > 0 ? IO_SUCCESS : IO_EMPTY;
+  }
+
+  void
+  close(void)
+  {
+    if (addr_ != MAP_FAILED)
+    {
+      munmap(addr_, size_);
+      addr_ = MAP_FAILED;
+    }
+    if (fd_ >= 0)
+    {
+      ::close(fd_);
+      fd_ = -1;
+    }
+    size_ = 0;
+    std::memset(&header_, 0, sizeof(BinaryHeader));
+    ts_ = nullptr;
+    c_ = nullptr;
+    polarity_ = nullptr;
+  }
+};
+
+template <typename T, int N>
+IO_STATUS
+loadBinary(const std::string& fname, Matrix<T>& c, Vector<T>& ts,
+           Vector<int>& polarity, int& width, int& height)
+{
+  MappedEvents<T, N> mevs;
+  const IO_STATUS ioStatus = mevs.open(fname);
+  if (ioStatus != IO_SUCCESS)
+  {
+    return ioStatus;
+  }
+  c = mevs.c();
+  ts = mevs.ts();
+  polarity = mevs.polarity();
+  width = mevs.width();
+  height = mevs.height();
+  return IO_SUCCESS;
+}
+
+template <typename T, int N>
+IO_STATUS
+loadBinary(const std::string& fname, EventBlock<T, N>& evs, int& width,
+           int& height)
+{
+  evs.weights.resize(0);
+  return loadBinary<T, N>(fname, evs.c, evs.ts, evs.polarity, width, height);
+}
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_EVENT_BINARY_IO_H
@@ -52,6 +52,37 @@ events2cv(const Events<T, N>& evs, const Ref<const Vector<T> >& w,
   }
 }
 
+// weighted by the block weights, if any
+template <typename T, int N>
+void
+events2cv(const EventBlockRef<T, N>& evs, const int width, const int height,
+          CvMatrix& img)
+{
+  assert(N >= 2);
+  const int nEvents = evs.nEvents();
+
+  img.create(height, width, CV_TYPE(T, 1));
+  img.setTo(0.0);
+  for (int k = 0; k < nEvents; ++k)
+  {
+    const int x = std::round(evs.c(0, k));
+    const int y = std::round(evs.c(1, k));
+    if (0 <= x && x < width && 0 <= y && y < height)
+    {
+      const T w = evs.weighted() ? evs.weights(k) : T(1.0);
+      img.at<T>(y, x) += w * static_cast<T>(evs.polarity(k));
+    }
+  }
+}
+
+template <typename T, int N>
+void
+events2cv(const EventBlock<T, N>& evs, const int width, const int height,
+          CvMatrix& img)
+{
+  events2cv<T, N>(EventBlockRef<T, N>(evs), width, height, img);
+}
+
 template <typename Derived, int N>
 void
 event2eigen(const Event<typename Derived::Scalar, N>& ev,
@@ -102,6 +133,14 @@ events2eigen(const Events<T, N>& evs, Matrix<T>& c, Vector<T>& ts,
     event2eigen(evs[k], c.col(k), ts(k), polarity(k));
   }
 }
+
+template <typename T, int N>
+void
+events2eigen(const Events<T, N>& evs, EventBlock<T, N>& block)
+{
+  block.weights.resize(0);
+  events2eigen(evs, block.c, block.ts, block.polarity);
+}
 }  // namespace EventEMin
 
 #endif  // EVENT_EMIN_EVENT_CONVERSION_H
@@ -0,0 +1,168 @@
+#ifndef EVENT_EMIN_EVENT_DECODER_H
+#define EVENT_EMIN_EVENT_DECODER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include "EventEMin/event/io.h"
+#include "EventEMin/event/type.h"
+#include "EventEMin/types_def.h"
+
+namespace EventEMin
+{
+/* streaming decoder of a binary recording: Derived::decode decodes the next
+   packet of words into the staged columns, and returns false at the end of
+   the stream; staged events are served in blocks of nEvents 2D events */
+template <typename Derived, typename T>
+class DecoderBase
+{
+ protected:
+  std::ifstream fin_;
+  int width_, height_;
+
+  // staged events, timestamps in microseconds
+  std::vector<std::int64_t> t_;
+  std::vector<std::uint16_t> x_, y_;
+  std::vector<std::int8_t> polarity_;
+  std::size_t next_;
+
+  // timestamp subtracted from every event
+  std::int64_t tsOrigin_;
+
+ public:
+  DecoderBase(void) : width_(0), height_(0), next_(0), tsOrigin_(0) {}
+
+  bool
+  isOpen(void) const
+  {
+    return fin_.is_open();
+  }
+  int
+  width(void) const
+  {
+    return width_;
+  }
+  int
+  height(void) const
+  {
+    return height_;
+  }
+  std::int64_t
+  tsOrigin(void) const
+  {
+    return tsOrigin_;
+  }
+
+  // reads the next nEvents events, in seconds since the origin
+  IO_STATUS
+  read(const int nEvents, EventBlock<T, 2>& evs)
+  {
+    evs.weights.resize(0);
+    evs.resize(nEvents);
+
+    int n = 0;
+    while (n < nEvents)
+    {
+      if (next_ == t_.size())
+      {
+        clearStaged();
+        if (!underlying().decode())
+        {
+          break;
+        }
+        continue;
+      }
+      const int m =
+          std::min(nEvents - n, static_cast<int>(t_.size() - next_));
+      copyStaged(m, n, evs);
+      n += m;
+    }
+
+    if (n == nEvents)
+    {
+      return IO_SUCCESS;
+    }
+    evs.conservativeResize(n);
+    return n > 0 ? IO_LESS : IO_EMPTY;
+  }
+
+  // reads all the remaining events
+  IO_STATUS
+  read(EventBlock<T, 2>& evs)
+  {
+    while (underlying().decode())
+    {
+    }
+    const int n = static_cast<int>(t_.size() - next_);
+    evs.weights.resize(0);
+    evs.resize(n);
+    copyStaged(n, 0, evs);
+    clearStaged();
+    return n > 0 ? IO_SUCCESS : IO_EMPTY;
+  }
+
+  void
+  close(void)
+  {
+    if (fin_.is_open())
+    {
+      fin_.close();
+    }
+    width_ = 0;
+    height_ = 0;
+    clearStaged();
+    tsOrigin_ = 0;
+  }
+
+ protected:
+  Derived&
+  underlying(void)
+  {
+    return static_cast<Derived&>(*this);
+  }
+
+  void
+  stage(const std::int64_t t, const int x, const int y, const int polarity)
+  {
+    t_.push_back(t);
+    x_.push_back(static_cast<std::uint16_t>(x));
+    y_.push_back(static_cast<std::uint16_t>(y));
+    polarity_.push_back(static_cast<std::int8_t>(polarity));
+  }
+
+ private:
+  void
+  copyStaged(const int m, const int start, EventBlock<T, 2>& evs)
+  {
+    const std::int64_t* t = t_.data() + next_;
+    const std::uint16_t* x = x_.data() + next_;
+    const std::uint16_t* y = y_.data() + next_;
+    const std::int8_t* polarity = polarity_.data() + next_;
+    T* c = evs.c.data() + 2 * start;
+    T* ts = evs.ts.data() + start;
+    int* p = evs.polarity.data() + start;
+    for (int k = 0; k < m; ++k)
+    {
+      c[2 * k] = static_cast<T>(x[k]);
+      c[2 * k + 1] = static_cast<T>(y[k]);
+      ts[k] = static_cast<T>(static_cast<double>(t[k] - tsOrigin_) * 1.0e-6);
+      p[k] = polarity[k];
+    }
+    next_ += m;
+  }
+
+  void
+  clearStaged(void)
+  {
+    t_.clear();
+    x_.clear();
+    y_.clear();
+    polarity_.clear();
+    next_ = 0;
+  }
+};
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_EVENT_DECODER_H
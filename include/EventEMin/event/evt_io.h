@@ -0,0 +1,283 @@
+#ifndef EVENT_EMIN_EVENT_EVT_IO_H
+#define EVENT_EMIN_EVENT_EVT_IO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "EventEMin/event/decoder.h"
+#include "EventEMin/event/io.h"
+#include "EventEMin/event/type.h"
+
+namespace EventEMin
+{
+enum EVT_FORMAT
+{
+  EVT_UNKNOWN = -1,
+  EVT_2,
+  EVT_3
+};
+
+/* streaming decoder of the vendor RAW formats EVT 2.0 (32-bit words) and
+   EVT 3.0 (16-bit words), little-endian, after the '%' header lines;
+   timestamps are in microseconds since the start of the recording */
+template <typename T>
+class EvtReader : public DecoderBase<EvtReader<T>, T>
+{
+ private:
+  typedef DecoderBase<EvtReader<T>, T> Base;
+  friend Base;
+
+  static constexpr std::size_t nWords_ = 1 << 16;
+
+  EVT_FORMAT format_;
+  std::vector<std::uint32_t> words32_;
+  std::vector<std::uint16_t> words16_;
+
+  // decoder state
+  std::int64_t tHigh_, tLow_, tLoops_;
+  int y_, xBase_, polarityBase_;
+  bool tValid_;
+
+ public:
+  EvtReader(void) : format_(EVT_UNKNOWN) { reset(); }
+  EvtReader(const std::string& fname) : EvtReader() { open(fname); }
+
+  EVT_FORMAT
+  format(void) const
+  {
+    return format_;
+  }
+
+  IO_STATUS
+  open(const std::string& fname)
+  {
+    close();
+    this->fin_.open(fname.c_str(), std::ios::binary);
+    if (!this->fin_.is_open())
+    {
+      return IO_FAIL;
+    }
+    readHeader();
+    if (format_ == EVT_UNKNOWN)
+    {
+      close();
+      return IO_FAIL;
+    }
+    return this->fin_.peek() == std::char_traits<char>::eof() ? IO_EMPTY
+                                                              : IO_SUCCESS;
+  }
+
+  void
+  close(void)
+  {
+    Base::close();
+    format_ = EVT_UNKNOWN;
+    reset();
+  }
+
+ private:
+  void
+  reset(void)
+  {
+    tHigh_ = 0;
+    tLow_ = 0;
+    tLoops_ = 0;
+    y_ = 0;
+    xBase_ = 0;
+    polarityBase_ = 1;
+    tValid_ = false;
+  }
+
+  /* header lines start with '%', e.g. "% format EVT3;height=720;width=1280",
+     up to the "% end" line when there is one, so that a payload whose first
+     byte is '%' is not read as header */
+  void
+  readHeader(void)
+  {
+    std::string line;
+    while (this->fin_.peek() == '%' && std::getline(this->fin_, line))
+    {
+      if (line.compare(0, 5, "% end") == 0)
+      {
+        break;
+      }
+      if (line.find("EVT2") != std::string::npos ||
+          line.find("evt 2.0") != std::string::npos)
+      {
+        format_ = EVT_2;
+      }
+      else if (line.find("EVT3") != std::string::npos ||
+               line.find("evt 3.0") != std::string::npos)
+      {
+        format_ = EVT_3;
+      }
+      int width, height;
+      std::size_t pos;
+      if ((pos = line.find("width=")) != std::string::npos &&
+          std::sscanf(line.c_str() + pos, "width=%d", &width) == 1)
+      {
+        this->width_ = width;
+      }
+      if ((pos = line.find("height=")) != std::string::npos &&
+          std::sscanf(line.c_str() + pos, "height=%d", &height) == 1)
+      {
+        this->height_ = height;
+      }
+      if ((pos = line.find("geometry")) != std::string::npos &&
+          std::sscanf(line.c_str() + pos, "geometry %dx%d", &width,
+                      &height) == 2)
+      {
+        this->width_ = width;
+        this->height_ = height;
+      }
+    }
+  }
+
+  bool
+  decode(void)
+  {
+    return format_ == EVT_2 ? decode2() : decode3();
+  }
+
+  template <typename W>
+  std::size_t
+  readWords(std::vector<W>& words)
+  {
+    words.resize(nWords_);
+    this->fin_.read(reinterpret_cast<char*>(words.data()),
+                    nWords_ * sizeof(W));
+    return this->fin_.gcount() / sizeof(W);
+  }
+
+  bool
+  decode2(void)
+  {
+    const std::size_t n = readWords(words32_);
+    if (n == 0)
+    {
+      return false;
+    }
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const std::uint32_t w = words32_[i];
+      switch (w >> 28)
+      {
+        // CD_OFF and CD_ON: ts low (6) | x (11) | y (11)
+        case 0x0:
+        case 0x1:
+          if (tValid_)
+          {
+            this->stage(tHigh_ | ((w >> 22) & 0x3F), (w >> 11) & 0x7FF,
+                        w & 0x7FF, (w >> 28) ? 1 : -1);
+          }
+          break;
+        // EVT_TIME_HIGH: ts high (28)
+        case 0x8:
+          tHigh_ = static_cast<std::int64_t>(w & 0x0FFFFFFF) << 6;
+          tValid_ = true;
+          break;
+        default:
+          break;
+      }
+    }
+    return true;
+  }
+
+  bool
+  decode3(void)
+  {
+    constexpr std::int64_t tPeriod = std::int64_t(1) << 24;
+
+    const std::size_t n = readWords(words16_);
+    if (n == 0)
+    {
+      return false;
+    }
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const std::uint16_t w = words16_[i];
+      const std::int64_t t = tLoops_ + (tHigh_ << 12) + tLow_;
+      switch (w >> 12)
+      {
+        // EVT_ADDR_Y: y (11)
+        case 0x0:
+          y_ = w & 0x7FF;
+          break;
+        // EVT_ADDR_X: polarity (1) | x (11)
+        case 0x2:
+          if (tValid_)
+          {
+            this->stage(t, w & 0x7FF, y_, (w & 0x800) ? 1 : -1);
+          }
+          break;
+        // VECT_BASE_X: polarity (1) | x (11)
+        case 0x3:
+          xBase_ = w & 0x7FF;
+          polarityBase_ = (w & 0x800) ? 1 : -1;
+          break;
+        // VECT_12 and VECT_8: validity mask of the next pixels
+        case 0x4:
+          stageVect(t, w & 0xFFF, 12);
+          break;
+        case 0x5:
+          stageVect(t, w & 0xFF, 8);
+          break;
+        // EVT_TIME_LOW: ts low (12)
+        case 0x6:
+          tLow_ = w & 0xFFF;
+          break;
+        // EVT_TIME_HIGH: ts high (12), wrapping every 2^24 us
+        case 0x8:
+        {
+          const std::int64_t tHigh = w & 0xFFF;
+          if (tValid_ && tHigh < tHigh_ && tHigh_ - tHigh > 0x800)
+          {
+            tLoops_ += tPeriod;
+          }
+          tHigh_ = tHigh;
+          tValid_ = true;
+          break;
+        }
+        default:
+          break;
+      }
+    }
+    return true;
+  }
+
+  void
+  stageVect(const std::int64_t t, std::uint32_t mask, const int nBits)
+  {
+    if (tValid_)
+    {
+      while (mask)
+      {
+        const int b = __builtin_ctz(mask);
+        this->stage(t, xBase_ + b, y_, polarityBase_);
+        mask &= mask - 1;
+      }
+    }
+    xBase_ += nBits;
+  }
+};
+
+template <typename T>
+IO_STATUS
+loadEvt(const std::string& fname, EventBlock<T, 2>& evs, int& width,
+        int& height)
+{
+  EvtReader<T> reader;
+  const IO_STATUS ioStatus = reader.open(fname);
+  if (ioStatus != IO_SUCCESS)
+  {
+    return ioStatus;
+  }
+  width = reader.width();
+  height = reader.height();
+  return reader.read(evs);
+}
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_EVENT_EVT_IO_H
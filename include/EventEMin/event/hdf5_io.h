@@ -0,0 +1,344 @@
+#ifndef EVENT_EMIN_EVENT_HDF5_IO_H
+#define EVENT_EMIN_EVENT_HDF5_IO_H
+
+#ifdef EventEMin_HDF5
+
+#include <hdf5.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "EventEMin/event/io.h"
+#include "EventEMin/event/type.h"
+#include "EventEMin/types_def.h"
+
+namespace EventEMin
+{
+/* chunked reader of events stored in HDF5, as in DSEC: datasets x, y, t (in
+   microseconds) and p under the events group, and optionally ms_to_idx (index
+   of the first event of every millisecond) and t_offset at the root */
+template <typename T>
+class Hdf5Reader
+{
+ private:
+  enum
+  {
+    X,
+    Y,
+    TS,
+    POLARITY,
+    NDatasets
+  };
+
+  hid_t file_;
+  hid_t datasets_[NDatasets];
+
+  std::int64_t nEvents_, next_, tOffset_;
+  std::vector<std::uint64_t> msToIdx_;
+
+  std::vector<std::int64_t> t_;
+
+ public:
+  Hdf5Reader(void) : file_(H5I_INVALID_HID), nEvents_(0), next_(0), tOffset_(0)
+  {
+    std::fill(datasets_, datasets_ + NDatasets, H5I_INVALID_HID);
+  }
+  Hdf5Reader(const std::string& fname, const std::string& group = "events")
+      : Hdf5Reader()
+  {
+    open(fname, group);
+  }
+  Hdf5Reader(const Hdf5Reader&) = delete;
+  Hdf5Reader&
+  operator=(const Hdf5Reader&) = delete;
+  ~Hdf5Reader(void) { close(); }
+
+  bool
+  isOpen(void) const
+  {
+    return file_ >= 0;
+  }
+  std::int64_t
+  nEvents(void) const
+  {
+    return nEvents_;
+  }
+  // index of the next event to read
+  std::int64_t
+  tell(void) const
+  {
+    return next_;
+  }
+  // offset of the timestamps, in microseconds
+  std::int64_t
+  tOffset(void) const
+  {
+    return tOffset_;
+  }
+  bool
+  indexed(void) const
+  {
+    return !msToIdx_.empty();
+  }
+
+  IO_STATUS
+  open(const std::string& fname, const std::string& group = "events")
+  {
+    close();
+
+    // a missing or non-HDF5 file is reported through the status only
+    H5E_BEGIN_TRY
+    {
+      file_ = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    }
+    H5E_END_TRY;
+    if (file_ < 0)
+    {
+      return IO_FAIL;
+    }
+    const char* names[NDatasets] = {"x", "y", "t", "p"};
+    for (int i = 0; i < NDatasets; ++i)
+    {
+      const std::string name(group + "/" + names[i]);
+      if (H5Lexists(file_, group.c_str(), H5P_DEFAULT) <= 0 ||
+          H5Lexists(file_, name.c_str(), H5P_DEFAULT) <= 0 ||
+          (datasets_[i] = H5Dopen2(file_, name.c_str(), H5P_DEFAULT)) < 0)
+      {
+        close();
+        return IO_FAIL;
+      }
+      const std::int64_t n = size(datasets_[i]);
+      if (n < 0 || (i > 0 && n != nEvents_))
+      {
+        close();
+        return IO_FAIL;
+      }
+      nEvents_ = n;
+    }
+
+    if (H5Lexists(file_, "ms_to_idx", H5P_DEFAULT) > 0)
+    {
+      const hid_t dataset = H5Dopen2(file_, "ms_to_idx", H5P_DEFAULT);
+      msToIdx_.resize(size(dataset));
+      if (!msToIdx_.empty() &&
+          H5Dread(dataset, H5T_NATIVE_UINT64, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                  msToIdx_.data()) < 0)
+      {
+        msToIdx_.clear();
+      }
+      H5Dclose(dataset);
+    }
+    if (H5Lexists(file_, "t_offset", H5P_DEFAULT) > 0)
+    {
+      const hid_t dataset = H5Dopen2(file_, "t_offset", H5P_DEFAULT);
+      if (H5Dread(dataset, H5T_NATIVE_INT64, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                  &tOffset_) < 0)
+      {
+        tOffset_ = 0;
+      }
+      H5Dclose(dataset);
+    }
+
+    return nEvents_ > 0 ? IO_SUCCESS : IO_EMPTY;
+  }
+
+  void
+  close(void)
+  {
+    for (int i = 0; i < NDatasets; ++i)
+    {
+      if (datasets_[i] >= 0)
+      {
+        H5Dclose(datasets_[i]);
+        datasets_[i] = H5I_INVALID_HID;
+      }
+    }
+    if (file_ >= 0)
+    {
+      H5Fclose(file_);
+      file_ = H5I_INVALID_HID;
+    }
+    nEvents_ = 0;
+    next_ = 0;
+    tOffset_ = 0;
+    msToIdx_.clear();
+  }
+
+  /* index of the first event at or after ts (in seconds), in constant time
+     through ms_to_idx, or by bisection otherwise */
+  std::int64_t
+  find(const T& ts)
+  {
+    const double us = static_cast<double>(ts) * 1.0e6;
+    if (us <= 0.0)
+    {
+      return 0;
+    }
+    std::int64_t first = 0, last = nEvents_;
+    if (indexed())
+    {
+      const std::int64_t ms = static_cast<std::int64_t>(us * 1.0e-3);
+      if (ms >= static_cast<std::int64_t>(msToIdx_.size()))
+      {
+        first = msToIdx_.back();
+      }
+      else
+      {
+        first = msToIdx_[ms];
+        if (ms + 1 < static_cast<std::int64_t>(msToIdx_.size()))
+        {
+          last = msToIdx_[ms + 1];
+        }
+      }
+    }
+    // refine within [first, last) by bisection on t
+    std::int64_t t;
+    while (first < last)
+    {
+      const std::int64_t mid = first + ((last - first) >> 1);
+      readTs(mid, 1, &t);
+      if (static_cast<double>(t) < us)
+      {
+        first = mid + 1;
+      }
+      else
+      {
+        last = mid;
+      }
+    }
+    return first;
+  }
+
+  void
+  seekIndex(const std::int64_t k)
+  {
+    next_ = std::min(std::max(k, std::int64_t(0)), nEvents_);
+  }
+  void
+  seek(const T& ts)
+  {
+    seekIndex(find(ts));
+  }
+
+  // reads the next nEvents events, timestamps in seconds
+  IO_STATUS
+  read(const int nEvents, EventBlock<T, 2>& evs)
+  {
+    if (next_ >= nEvents_)
+    {
+      return IO_EMPTY;
+    }
+    const int n = static_cast<int>(
+        std::min(static_cast<std::int64_t>(nEvents), nEvents_ - next_));
+    if (!readBlock(next_, n, evs))
+    {
+      return IO_FAIL;
+    }
+    next_ += n;
+    return n == nEvents ? IO_SUCCESS : IO_LESS;
+  }
+
+  // reads the next events before eT (in seconds)
+  IO_STATUS
+  read(const T& eT, EventBlock<T, 2>& evs)
+  {
+    if (next_ >= nEvents_)
+    {
+      return IO_EMPTY;
+    }
+    const std::int64_t end = std::max(find(eT), next_);
+    const int n = static_cast<int>(end - next_);
+    if (!readBlock(next_, n, evs))
+    {
+      return IO_FAIL;
+    }
+    next_ = end;
+    return IO_SUCCESS;
+  }
+
+ private:
+  static std::int64_t
+  size(const hid_t dataset)
+  {
+    const hid_t space = H5Dget_space(dataset);
+    hsize_t dims[1] = {0};
+    if (space < 0 || H5Sget_simple_extent_ndims(space) != 1)
+    {
+      H5Sclose(space);
+      return -1;
+    }
+    H5Sget_simple_extent_dims(space, dims, nullptr);
+    H5Sclose(space);
+    return static_cast<std::int64_t>(dims[0]);
+  }
+
+  template <typename M>
+  bool
+  readSlab(const int i, const hid_t memType, const std::int64_t start,
+           const int n, M* data, const int stride = 1) const
+  {
+    const hsize_t fileStart[1] = {static_cast<hsize_t>(start)};
+    const hsize_t count[1] = {static_cast<hsize_t>(n)};
+    const hsize_t memSize[1] = {static_cast<hsize_t>(n) * stride};
+    const hsize_t memStart[1] = {0};
+    const hsize_t memStride[1] = {static_cast<hsize_t>(stride)};
+
+    const hid_t fileSpace = H5Dget_space(datasets_[i]);
+    const hid_t memSpace = H5Screate_simple(1, memSize, nullptr);
+    H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, fileStart, nullptr, count,
+                        nullptr);
+    H5Sselect_hyperslab(memSpace, H5S_SELECT_SET, memStart, memStride, count,
+                        nullptr);
+    const herr_t status = H5Dread(datasets_[i], memType, memSpace, fileSpace,
+                                  H5P_DEFAULT, data);
+    H5Sclose(memSpace);
+    H5Sclose(fileSpace);
+    return status >= 0;
+  }
+
+  bool
+  readTs(const std::int64_t start, const int n, std::int64_t* t) const
+  {
+    return readSlab(TS, H5T_NATIVE_INT64, start, n, t);
+  }
+
+  // the coordinates are read straight into the interleaved rows of c
+  bool
+  readBlock(const std::int64_t start, const int n, EventBlock<T, 2>& evs)
+  {
+    const hid_t memType =
+        sizeof(T) == sizeof(double) ? H5T_NATIVE_DOUBLE : H5T_NATIVE_FLOAT;
+    evs.weights.resize(0);
+    evs.resize(n);
+    if (n == 0)
+    {
+      return true;
+    }
+    t_.resize(n);
+    if (!readSlab(X, memType, start, n, evs.c.data(), 2) ||
+        !readSlab(Y, memType, start, n, evs.c.data() + 1, 2) ||
+        !readTs(start, n, t_.data()) ||
+        !readSlab(POLARITY, H5T_NATIVE_INT, start, n, evs.polarity.data()))
+    {
+      return false;
+    }
+    for (int k = 0; k < n; ++k)
+    {
+      evs.ts(k) = static_cast<T>(static_cast<double>(t_[k]) * 1.0e-6);
+      if (evs.polarity(k) == 0)
+      {
+        evs.polarity(k) = -1;
+      }
+    }
+    return true;
+  }
+};
+}  // namespace EventEMin
+
+#endif  // EventEMin_HDF5
+
+#endif  // EVENT_EMIN_EVENT_HDF5_IO_H
@@ -0,0 +1,276 @@
+#ifndef EVENT_EMIN_EVENT_INDEX_H
+#define EVENT_EMIN_EVENT_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "EventEMin/event/binary_io.h"
+#include "EventEMin/event/io.h"
+#include "EventEMin/event/parallel_io.h"
+#include "EventEMin/types_def.h"
+
+namespace EventEMin
+{
+/* sparse index of a text events file, storing the timestamp, ordinal and
+   byte offset of an event every stride events (and every tsStep, if set) */
+template <typename T>
+class TimestampIndex
+{
+ private:
+  static constexpr char magic_[8] = {'E', 'V', 'E', 'M', 'I', 'N', 'I', '\0'};
+
+  // size of the indexed file, to detect a stale index
+  std::uint64_t fsize_;
+
+  std::vector<T> ts_;
+  std::vector<std::uint64_t> ordinal_, offset_;
+
+ public:
+  TimestampIndex(void) : fsize_(0) {}
+
+  int
+  size(void) const
+  {
+    return static_cast<int>(ts_.size());
+  }
+  bool
+  empty(void) const
+  {
+    return ts_.empty();
+  }
+  T
+  ts(const int i) const
+  {
+    return ts_[i];
+  }
+  std::uint64_t
+  ordinal(const int i) const
+  {
+    return ordinal_[i];
+  }
+  std::uint64_t
+  offset(const int i) const
+  {
+    return offset_[i];
+  }
+
+  static std::string
+  sidecar(const std::string& fname)
+  {
+    return fname + ".idx";
+  }
+
+  IO_STATUS
+  build(const std::string& fname, const int stride = 1 << 14,
+        const T& tsStep = T(0.0))
+  {
+    assert(0 < stride);
+
+    std::ifstream fin(fname.c_str(), std::ios::binary);
+    if (!fin.is_open())
+    {
+      return IO_FAIL;
+    }
+    clear();
+
+    std::string line;
+    std::uint64_t offset = 0, ordinal = 0;
+    T tsNext = T(0.0);
+    while (std::getline(fin, line))
+    {
+      const char* first = line.data();
+      const char* last = first + line.size();
+      T ts;
+      if (!parse::isEmptyLine(first, last))
+      {
+        if (!parse::scalar<T>(first, last, ts))
+        {
+          break;
+        }
+        if (ordinal % stride == 0 ||
+            (T(0.0) < tsStep && (empty() || tsNext <= ts)))
+        {
+          ts_.push_back(ts);
+          ordinal_.push_back(ordinal);
+          offset_.push_back(offset);
+          tsNext = ts + tsStep;
+        }
+        ++ordinal;
+      }
+      offset += line.size() + 1;
+    }
+    fsize_ = fileSize(fname);
+
+    return empty() ? IO_EMPTY : IO_SUCCESS;
+  }
+
+  IO_STATUS
+  load(const std::string& fnameIndex, const std::string& fname)
+  {
+    std::ifstream fin(fnameIndex.c_str(), std::ios::binary);
+    if (!fin.is_open())
+    {
+      return IO_FAIL;
+    }
+    clear();
+
+    char magic[8];
+    std::uint32_t scalarSize;
+    std::uint64_t n;
+    fin.read(magic, sizeof(magic));
+    fin.read(reinterpret_cast<char*>(&scalarSize), sizeof(scalarSize));
+    fin.read(reinterpret_cast<char*>(&fsize_), sizeof(fsize_));
+    fin.read(reinterpret_cast<char*>(&n), sizeof(n));
+    if (!fin || std::memcmp(magic, magic_, sizeof(magic)) != 0 ||
+        scalarSize != sizeof(T) || fsize_ != fileSize(fname))
+    {
+      clear();
+      return IO_FAIL;
+    }
+
+    ts_.resize(n);
+    ordinal_.resize(n);
+    offset_.resize(n);
+    fin.read(reinterpret_cast<char*>(ts_.data()), n * sizeof(T));
+    fin.read(reinterpret_cast<char*>(ordinal_.data()),
+             n * sizeof(std::uint64_t));
+    fin.read(reinterpret_cast<char*>(offset_.data()),
+             n * sizeof(std::uint64_t));
+    if (!fin)
+    {
+      clear();
+      return IO_FAIL;
+    }
+    return empty() ? IO_EMPTY : IO_SUCCESS;
+  }
+
+  IO_STATUS
+  save(const std::string& fnameIndex) const
+  {
+    if (empty())
+    {
+      return IO_EMPTY;
+    }
+    std::ofstream fout(fnameIndex.c_str(), std::ios::binary | std::ios::trunc);
+    if (!fout.is_open())
+    {
+      return IO_FAIL;
+    }
+
+    const std::uint32_t scalarSize = sizeof(T);
+    const std::uint64_t n = ts_.size();
+    fout.write(magic_, sizeof(magic_));
+    fout.write(reinterpret_cast<const char*>(&scalarSize), sizeof(scalarSize));
+    fout.write(reinterpret_cast<const char*>(&fsize_), sizeof(fsize_));
+    fout.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    fout.write(reinterpret_cast<const char*>(ts_.data()), n * sizeof(T));
+    fout.write(reinterpret_cast<const char*>(ordinal_.data()),
+               n * sizeof(std::uint64_t));
+    fout.write(reinterpret_cast<const char*>(offset_.data()),
+               n * sizeof(std::uint64_t));
+    return fout.good() ? IO_SUCCESS : IO_FAIL;
+  }
+
+  // loads the sidecar index of fname, building and saving it if needed
+  IO_STATUS
+  open(const std::string& fname, const int stride = 1 << 14,
+       const T& tsStep = T(0.0))
+  {
+    if (load(sidecar(fname), fname) == IO_SUCCESS)
+    {
+      return IO_SUCCESS;
+    }
+    const IO_STATUS ioStatus = build(fname, stride, tsStep);
+    if (ioStatus == IO_SUCCESS)
+    {
+      // a read-only location only costs rebuilding the index next time
+      save(sidecar(fname));
+    }
+    return ioStatus;
+  }
+
+  // last entry strictly before ts, or -1 if there is none
+  int
+  find(const T& ts) const
+  {
+    return static_cast<int>(std::lower_bound(ts_.begin(), ts_.end(), ts) -
+                            ts_.begin()) -
+           1;
+  }
+
+  // positions fin at most stride events before the first event at ts
+  void
+  seek(std::ifstream& fin, const T& ts) const
+  {
+    const int i = find(ts);
+    fin.clear();
+    fin.seekg(i < 0 ? 0 : offset_[i]);
+  }
+
+  void
+  clear(void)
+  {
+    fsize_ = 0;
+    ts_.clear();
+    ordinal_.clear();
+    offset_.clear();
+  }
+
+ private:
+  static std::uint64_t
+  fileSize(const std::string& fname)
+  {
+    std::ifstream fin(fname.c_str(), std::ios::binary | std::ios::ate);
+    return fin.is_open() ? static_cast<std::uint64_t>(fin.tellg()) : 0;
+  }
+};
+
+template <typename T, int N>
+IO_STATUS
+load(const std::string& fname, const TimestampIndex<T>& index, const T& sT,
+     const T& eT, Events<T, N>& evs)
+{
+  std::ifstream fin(fname.c_str());
+  if (!fin.is_open())
+  {
+    return IO_FAIL;
+  }
+  index.seek(fin, sT);
+  return load<T, N>(fin, sT, eT, evs);
+}
+
+template <typename T, int N>
+IO_STATUS
+load(const std::string& fname, const TimestampIndex<T>& index, const T& sT,
+     const int nEvents, Events<T, N>& evs)
+{
+  std::ifstream fin(fname.c_str());
+  if (!fin.is_open())
+  {
+    return IO_FAIL;
+  }
+  index.seek(fin, sT);
+  return load<T, N>(fin, sT, nEvents, evs);
+}
+
+template <typename T>
+IO_STATUS
+loadDepthThresh(const std::string& fname, const TimestampIndex<T>& index,
+                const T& sT, const int nEvents, const T& depthMin,
+                const T& depthMax, Events<T, 3>& evs)
+{
+  std::ifstream fin(fname.c_str());
+  if (!fin.is_open())
+  {
+    return IO_FAIL;
+  }
+  index.seek(fin, sT);
+  return loadDepthThresh<T>(fin, sT, nEvents, depthMin, depthMax, evs);
+}
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_EVENT_INDEX_H
@@ -141,14 +141,8 @@ load(const std::string& fname, Events<T, N>& evs)
 
 template <typename T, int N>
 IO_STATUS
-load(const std::string& fname, const T& sT, const T& eT, Events<T, N>& evs)
+load(std::ifstream& fin, const T& sT, const T& eT, Events<T, N>& evs)
 {
-  std::ifstream fin(fname.c_str());
-  if (!fin.is_open())
-  {
-    return IO_FAIL;
-  }
-
   evs.clear();
   Event<T, N> ev;
   while (load<T, N>(fin, ev) == IO_SUCCESS && ev.ts < sT)
@@ -168,15 +162,20 @@ load(const std::string& fname, const T& sT, const T& eT, Events<T, N>& evs)
 
 template <typename T, int N>
 IO_STATUS
-load(const std::string& fname, const T& sT, const int nEvents,
-     Events<T, N>& evs)
+load(const std::string& fname, const T& sT, const T& eT, Events<T, N>& evs)
 {
   std::ifstream fin(fname.c_str());
   if (!fin.is_open())
   {
     return IO_FAIL;
   }
+  return load<T, N>(fin, sT, eT, evs);
+}
 
+template <typename T, int N>
+IO_STATUS
+load(std::ifstream& fin, const T& sT, const int nEvents, Events<T, N>& evs)
+{
   evs.clear();
   evs.reserve(nEvents);
   Event<T, N> ev;
@@ -200,6 +199,19 @@ load(const std::string& fname, const T& sT, const int nEvents,
   return IO_LESS;
 }
 
+template <typename T, int N>
+IO_STATUS
+load(const std::string& fname, const T& sT, const int nEvents,
+     Events<T, N>& evs)
+{
+  std::ifstream fin(fname.c_str());
+  if (!fin.is_open())
+  {
+    return IO_FAIL;
+  }
+  return load<T, N>(fin, sT, nEvents, evs);
+}
+
 template <typename T, int N>
 IO_STATUS
 load(const int nEvents, std::ifstream& fin, Events<T, N>& evs)
@@ -257,6 +269,14 @@ load(const int nEvents, std::ifstream& fin, Matrix<T>& c, Vector<T>& ts,
   return IO_LESS;
 }
 
+template <typename T, int N>
+IO_STATUS
+load(const int nEvents, std::ifstream& fin, EventBlock<T, N>& evs)
+{
+  evs.weights.resize(0);
+  return load<T, N>(nEvents, fin, evs.c, evs.ts, evs.polarity);
+}
+
 template <typename T, int N>
 IO_STATUS
 load(const T& eT, std::ifstream& fin, Events<T, N>& evs)
@@ -293,15 +313,9 @@ load(const T& eT, std::ifstream& fin, Matrix<T>& c, Vector<T>& ts,
 
 template <typename T>
 IO_STATUS
-loadDepthThresh(const std::string& fname, const T& sT, const int nEvents,
+loadDepthThresh(std::ifstream& fin, const T& sT, const int nEvents,
                 const T& depthMin, const T& depthMax, Events<T, 3>& evs)
 {
-  std::ifstream fin(fname.c_str());
-  if (!fin.is_open())
-  {
-    return IO_FAIL;
-  }
-
   evs.clear();
   evs.reserve(nEvents);
   Event<T, 3> ev;
@@ -329,6 +343,19 @@ loadDepthThresh(const std::string& fname, const T& sT, const int nEvents,
   return IO_LESS;
 }
 
+template <typename T>
+IO_STATUS
+loadDepthThresh(const std::string& fname, const T& sT, const int nEvents,
+                const T& depthMin, const T& depthMax, Events<T, 3>& evs)
+{
+  std::ifstream fin(fname.c_str());
+  if (!fin.is_open())
+  {
+    return IO_FAIL;
+  }
+  return loadDepthThresh<T>(fin, sT, nEvents, depthMin, depthMax, evs);
+}
+
 template <typename T>
 IO_STATUS
 loadDepthThresh(const int nEvents, const T& depthMin, const T& depthMax,
@@ -365,6 +392,16 @@ loadDepthThresh(const int nEvents, const T& depthMin, const T& depthMax,
   return IO_LESS;
 }
 
+template <typename T>
+IO_STATUS
+loadDepthThresh(const int nEvents, const T& depthMin, const T& depthMax,
+                std::ifstream& fin, EventBlock<T, 3>& evs)
+{
+  evs.weights.resize(0);
+  return loadDepthThresh<T>(nEvents, depthMin, depthMax, fin, evs.c, evs.ts,
+                            evs.polarity);
+}
+
 template <typename T, int N>
 IO_STATUS
 save(const std::string& fname, const Events<T, N>& evs)
@@ -568,6 +605,17 @@ undistort(const int xMin, const int xMax, const int yMin, const int yMax,
   return IO_LESS;
 }
 
+template <typename T, int N>
+IO_STATUS
+undistort(const int xMin, const int xMax, const int yMin, const int yMax,
+          const CvMatrix& map, const int nEvents, std::ifstream& fin,
+          EventBlock<T, N>& evs)
+{
+  evs.weights.resize(0);
+  return undistort<T, N>(xMin, xMax, yMin, yMax, map, nEvents, fin, evs.c,
+                         evs.ts, evs.polarity);
+}
+
 template <typename T, int N>
 IO_STATUS
 undistort(const int xMin, const int xMax, const int yMin, const int yMax,
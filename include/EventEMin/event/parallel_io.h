@@ -0,0 +1,271 @@
+#ifndef EVENT_EMIN_EVENT_PARALLEL_IO_H
+#define EVENT_EMIN_EVENT_PARALLEL_IO_H
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "EventEMin/event/io.h"
+#include "EventEMin/types_def.h"
+
+namespace EventEMin
+{
+namespace parse
+{
+inline bool
+isBlank(const char ch)
+{
+  return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+inline const char*
+skipBlanks(const char* first, const char* last)
+{
+  while (first < last && isBlank(*first))
+  {
+    ++first;
+  }
+  return first;
+}
+
+template <typename T>
+bool
+scalar(const char*& first, const char* last, T& val)
+{
+  first = skipBlanks(first, last);
+  if (first < last && *first == '+')
+  {
+    ++first;
+  }
+  const std::from_chars_result res = std::from_chars(first, last, val);
+  if (res.ec != std::errc())
+  {
+    return false;
+  }
+  first = res.ptr;
+  return true;
+}
+
+// parses one line "ts c(0) ... c(N-1) polarity" in [first, last)
+template <typename T, int N>
+bool
+event(const char* first, const char* last, T* c, T& ts, int& polarity)
+{
+  if (!scalar<T>(first, last, ts))
+  {
+    return false;
+  }
+  for (int d = 0; d < N; ++d)
+  {
+    if (!scalar<T>(first, last, c[d]))
+    {
+      return false;
+    }
+  }
+  if (!scalar<int>(first, last, polarity))
+  {
+    return false;
+  }
+  if (polarity == 0)
+  {
+    polarity = -1;
+  }
+  return true;
+}
+
+inline bool
+isEmptyLine(const char* first, const char* last)
+{
+  return skipBlanks(first, last) == last;
+}
+
+inline const char*
+lineEnd(const char* first, const char* last)
+{
+  return std::find(first, last, '\n');
+}
+
+// splits [0, size) into at most nChunks ranges starting at line boundaries
+inline void
+chunks(const std::vector<char>& buffer, const int nChunks,
+       std::vector<std::size_t>& bounds)
+{
+  const std::size_t size = buffer.size();
+  bounds.assign(1, 0);
+  for (int i = 1; i < nChunks; ++i)
+  {
+    std::size_t pos = std::max(bounds.back(), size * i / nChunks);
+    const char* end = lineEnd(buffer.data() + pos, buffer.data() + size);
+    pos = std::min(static_cast<std::size_t>(end - buffer.data()) + 1, size);
+    if (pos > bounds.back() && pos < size)
+    {
+      bounds.push_back(pos);
+    }
+  }
+  bounds.push_back(size);
+}
+
+inline int
+countLines(const char* first, const char* last)
+{
+  int n = 0;
+  while (first < last)
+  {
+    const char* end = lineEnd(first, last);
+    if (!isEmptyLine(first, end))
+    {
+      ++n;
+    }
+    first = end + 1;
+  }
+  return n;
+}
+}  // namespace parse
+
+inline IO_STATUS
+readFile(const std::string& fname, std::vector<char>& buffer)
+{
+  std::ifstream fin(fname.c_str(), std::ios::binary | std::ios::ate);
+  if (!fin.is_open())
+  {
+    return IO_FAIL;
+  }
+  const std::streamsize size = fin.tellg();
+  fin.seekg(0);
+  buffer.resize(size);
+  if (size > 0 && !fin.read(buffer.data(), size))
+  {
+    return IO_FAIL;
+  }
+  return size > 0 ? IO_SUCCESS : IO_EMPTY;
+}
+
+// multi-threaded parser of the text format, preserving the order of events
+template <typename T, int N>
+IO_STATUS
+loadParallel(const std::string& fname, Matrix<T>& c, Vector<T>& ts,
+             Vector<int>& polarity)
+{
+  std::vector<char> buffer;
+  const IO_STATUS ioStatus = readFile(fname, buffer);
+  if (ioStatus != IO_SUCCESS)
+  {
+    return ioStatus;
+  }
+
+#ifdef _OPENMP
+  const int nThreads = omp_get_max_threads();
+#else
+  const int nThreads = 1;
+#endif
+  // a few chunks per thread balance lines of different lengths
+  std::vector<std::size_t> bounds;
+  parse::chunks(buffer, nThreads << 2, bounds);
+  const int nChunks = static_cast<int>(bounds.size()) - 1;
+
+  // number of lines per chunk gives the position of each chunk
+  std::vector<int> nLines(nChunks), nParsed(nChunks);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < nChunks; ++i)
+  {
+    nLines[i] = parse::countLines(buffer.data() + bounds[i],
+                                  buffer.data() + bounds[i + 1]);
+  }
+  std::vector<int> offset(nChunks + 1, 0);
+  for (int i = 0; i < nChunks; ++i)
+  {
+    offset[i + 1] = offset[i] + nLines[i];
+  }
+  const int nEvents = offset[nChunks];
+  if (nEvents == 0)
+  {
+    return IO_EMPTY;
+  }
+
+  c.resize(N, nEvents);
+  ts.resize(nEvents);
+  polarity.resize(nEvents);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < nChunks; ++i)
+  {
+    const char* first = buffer.data() + bounds[i];
+    const char* last = buffer.data() + bounds[i + 1];
+    int k = offset[i];
+    nParsed[i] = 0;
+    while (first < last)
+    {
+      const char* end = parse::lineEnd(first, last);
+      if (!parse::isEmptyLine(first, end))
+      {
+        if (!parse::event<T, N>(first, end, &c(0, k), ts(k), polarity(k)))
+        {
+          break;
+        }
+        ++k;
+        ++nParsed[i];
+      }
+      first = end + 1;
+    }
+  }
+
+  // events after the first malformed line are discarded
+  for (int i = 0; i < nChunks; ++i)
+  {
+    if (nParsed[i] < nLines[i])
+    {
+      const int n = offset[i] + nParsed[i];
+      if (n == 0)
+      {
+        return IO_EMPTY;
+      }
+      c.conservativeResize(N, n);
+      ts.conservativeResize(n);
+      polarity.conservativeResize(n);
+      return IO_LESS;
+    }
+  }
+  return IO_SUCCESS;
+}
+
+template <typename T, int N>
+IO_STATUS
+loadParallel(const std::string& fname, EventBlock<T, N>& evs)
+{
+  evs.weights.resize(0);
+  return loadParallel<T, N>(fname, evs.c, evs.ts, evs.polarity);
+}
+
+template <typename T, int N>
+IO_STATUS
+loadParallel(const std::string& fname, Events<T, N>& evs)
+{
+  Matrix<T> c;
+  Vector<T> ts;
+  Vector<int> polarity;
+  const IO_STATUS ioStatus = loadParallel<T, N>(fname, c, ts, polarity);
+  if (ioStatus == IO_SUCCESS || ioStatus == IO_LESS)
+  {
+    const int nEvents = ts.size();
+    evs.clear();
+    evs.reserve(nEvents);
+    for (int k = 0; k < nEvents; ++k)
+    {
+      evs.emplace_back(c.col(k), ts(k), polarity(k));
+    }
+  }
+  return ioStatus;
+}
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_EVENT_PARALLEL_IO_H
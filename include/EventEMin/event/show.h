@@ -36,6 +36,26 @@ showGray(const Events<T, N>& evs, const DenseBase<Derived>& w, const int width,
   cv2gray(img);
   cv::imshow(imgName, img);
 }
+
+template <typename T, int N>
+void
+showGray(const EventBlockRef<T, N>& evs, const int width, const int height,
+         const std::string& imgName = "Image of Events")
+{
+  assert(N >= 2);
+  CvMatrix img;
+  events2cv<T, N>(evs, width, height, img);
+  cv2gray(img);
+  cv::imshow(imgName, img);
+}
+
+template <typename T, int N>
+void
+showGray(const EventBlock<T, N>& evs, const int width, const int height,
+         const std::string& imgName = "Image of Events")
+{
+  showGray<T, N>(EventBlockRef<T, N>(evs), width, height, imgName);
+}
 }  // namespace EventEMin
 
 #endif  // EVENT_EMIN_EVENT_SHOW_H
@@ -1,6 +1,8 @@
 #ifndef EVENT_EMIN_EVENT_TYPE_H
 #define EVENT_EMIN_EVENT_TYPE_H
 
+#include <cassert>
+#include <cstddef>
 #include <iostream>
 
 #include "EventEMin/types_def.h"
@@ -46,6 +48,129 @@ struct Event
 
 template <typename T, int N>
 using Events = StdVector<Event<T, N> >;
+
+template <typename T, int N>
+struct EventBlockRef;
+
+// structure of arrays of a sequence of events, with optional weights
+template <typename T, int N>
+struct EventBlock
+{
+  Matrix<T> c;
+  Vector<T> ts;
+  Vector<int> polarity;
+  // empty if the events are not weighted
+  Vector<T> weights;
+
+  EventBlock(void) : c(N, 0) {}
+  explicit EventBlock(const int nEvents) { resize(nEvents); }
+
+  int
+  nEvents(void) const
+  {
+    return ts.size();
+  }
+  bool
+  empty(void) const
+  {
+    return nEvents() == 0;
+  }
+  bool
+  weighted(void) const
+  {
+    return weights.size() > 0;
+  }
+
+  void
+  resize(const int nEvents)
+  {
+    c.resize(N, nEvents);
+    ts.resize(nEvents);
+    polarity.resize(nEvents);
+    if (weighted())
+    {
+      weights.resize(nEvents);
+    }
+  }
+  void
+  conservativeResize(const int nEvents)
+  {
+    c.conservativeResize(N, nEvents);
+    ts.conservativeResize(nEvents);
+    polarity.conservativeResize(nEvents);
+    if (weighted())
+    {
+      weights.conservativeResize(nEvents);
+    }
+  }
+  void
+  clear(void)
+  {
+    c.resize(N, 0);
+    ts.resize(0);
+    polarity.resize(0);
+    weights.resize(0);
+  }
+
+  EventBlockRef<T, N>
+  slice(const int start, const int n) const
+  {
+    return EventBlockRef<T, N>(*this).slice(start, n);
+  }
+};
+
+// view of a block of events, or of a window of it, without copies
+template <typename T, int N>
+struct EventBlockRef
+{
+  Map<const Matrix<T> > c;
+  Map<const Vector<T> > ts;
+  Map<const Vector<int> > polarity;
+  Map<const Vector<T> > weights;
+
+  EventBlockRef(const T* c, const T* ts, const int* polarity,
+                const T* weights, const int nEvents)
+      : c(c, N, nEvents),
+        ts(ts, nEvents),
+        polarity(polarity, nEvents),
+        weights(weights, weights == nullptr ? 0 : nEvents)
+  {
+  }
+  EventBlockRef(const EventBlock<T, N>& evs)
+      : EventBlockRef(evs.c.data(), evs.ts.data(), evs.polarity.data(),
+                      evs.weighted() ? evs.weights.data() : nullptr,
+                      evs.nEvents())
+  {
+    assert(evs.c.rows() == N);
+    assert(evs.c.cols() == evs.nEvents());
+    assert(evs.polarity.size() == evs.nEvents());
+  }
+
+  int
+  nEvents(void) const
+  {
+    return ts.size();
+  }
+  bool
+  empty(void) const
+  {
+    return nEvents() == 0;
+  }
+  bool
+  weighted(void) const
+  {
+    return weights.size() > 0;
+  }
+
+  EventBlockRef
+  slice(const int start, const int n) const
+  {
+    assert(0 <= start && 0 <= n && start + n <= nEvents());
+    return EventBlockRef(c.data() + static_cast<std::size_t>(N) * start,
+                         ts.data() + start, polarity.data() + start,
+                         weighted() ? weights.data() + start : nullptr, n);
+  }
+};
 }  // namespace EventEMin
 
 #endif  // EVENT_EMIN_EVENT_TYPE_H
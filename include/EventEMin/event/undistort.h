@@ -5,7 +5,10 @@
 #include <cmath>
 #include <fstream>
 #include <opencv2/opencv.hpp>
+#include <vector>
 
+#include "EventEMin/event/io.h"
+#include "EventEMin/event/transform.h"
 #include "EventEMin/event/type.h"
 #include "EventEMin/types_def.h"
 
@@ -38,6 +41,191 @@ undistort(const int xMin, const int xMax, const int yMin, const int yMax,
     }
   }
 }
+
+/* per-pixel lookup table from raw pixel coordinates to undistorted and
+   unprojected coordinates, built from the undistortion map of initUndistort;
+   pixels whose undistorted position falls outside the bounds are masked out */
+template <typename T>
+class UndistortionLUT
+{
+ private:
+  int width_, height_;
+
+  // normalised coordinates of pixel (x, y) at column y * width + x
+  Matrix<T> c_;
+  std::vector<unsigned char> mask_;
+
+ public:
+  UndistortionLUT(void) : width_(0), height_(0) {}
+  UndistortionLUT(const int xMin, const int xMax, const int yMin,
+                  const int yMax, const CvMatrix& map,
+                  const Ref<const Matrix<T, 3, 3> >& camParams)
+  {
+    init(xMin, xMax, yMin, yMax, map, camParams);
+  }
+
+  int
+  width(void) const
+  {
+    return width_;
+  }
+  int
+  height(void) const
+  {
+    return height_;
+  }
+
+  void
+  init(const int xMin, const int xMax, const int yMin, const int yMax,
+       const CvMatrix& map, const Ref<const Matrix<T, 3, 3> >& camParams)
+  {
+    width_ = map.cols;
+    height_ = map.rows;
+    c_.resize(2, width_ * height_);
+    mask_.resize(width_ * height_);
+
+    for (int y = 0; y < height_; ++y)
+    {
+      const int yy = y * width_;
+      for (int x = 0; x < width_; ++x)
+      {
+        const CvVector<T, 2> mapPoint = map.at<CvVector<T, 2> >(y, x);
+        const int xu = static_cast<int>(std::round(mapPoint[0]));
+        const int yu = static_cast<int>(std::round(mapPoint[1]));
+        c_.col(yy + x) << mapPoint[0], mapPoint[1];
+        mask_[yy + x] = xMin <= xu && xu < xMax && yMin <= yu && yu < yMax;
+      }
+    }
+    unprojectEvents<T, 2>()(camParams, c_);
+  }
+
+  /* maps raw coordinates to their final form, in 3D scaled by the depth
+     as in unprojectEvents; returns false if the event is masked out */
+  template <int N>
+  bool
+  operator()(const Ref<const Vector<T, N> >& raw, Ref<Vector<T, N> > c) const
+  {
+    static_assert(N == 2 || N == 3, "only 2D and 3D events are supported");
+
+    const int x = static_cast<int>(std::round(raw(0)));
+    const int y = static_cast<int>(std::round(raw(1)));
+    if (x < 0 || x >= width_ || y < 0 || y >= height_)
+    {
+      return false;
+    }
+    const int i = y * width_ + x;
+    if (!mask_[i])
+    {
+      return false;
+    }
+    if constexpr (N == 3)
+    {
+      c << raw(2) * c_(0, i), raw(2) * c_(1, i), raw(2);
+    }
+    else
+    {
+      c = c_.col(i);
+    }
+    return true;
+  }
+};
+
+// undistorts and unprojects a block of raw events in place, dropping the
+// events masked out by the lookup table
+template <typename T, int N>
+void
+undistortUnproject(const UndistortionLUT<T>& lut, EventBlock<T, N>& evs)
+{
+  const bool weighted = evs.weighted();
+  int n = 0;
+  for (int k = 0; k < evs.nEvents(); ++k)
+  {
+    const Vector<T, N> raw(evs.c.col(k));
+    if (lut.template operator()<N>(raw, evs.c.col(n)))
+    {
+      evs.ts(n) = evs.ts(k);
+      evs.polarity(n) = evs.polarity(k);
+      if (weighted)
+      {
+        evs.weights(n) = evs.weights(k);
+      }
+      ++n;
+    }
+  }
+  evs.conservativeResize(n);
+}
+
+// reads the next event within the lookup table, directly in its final form
+template <typename T, int N>
+IO_STATUS
+undistortUnproject(const UndistortionLUT<T>& lut, std::ifstream& fin,
+                   Ref<Vector<T, N> > c, T& ts, int& polarity)
+{
+  Vector<T, N> raw;
+  while (fin >> ts)
+  {
+    for (int d = 0; d < N; ++d)
+    {
+      fin >> raw(d);
+    }
+    fin >> polarity;
+    if (!fin)
+    {
+      break;
+    }
+    if (polarity == 0)
+    {
+      polarity = -1;
+    }
+    if (lut.template operator()<N>(raw, c))
+    {
+      return IO_SUCCESS;
+    }
+  }
+  return IO_EMPTY;
+}
+
+template <typename T, int N>
+IO_STATUS
+undistortUnproject(const UndistortionLUT<T>& lut, const int nEvents,
+                   std::ifstream& fin, Matrix<T>& c, Vector<T>& ts,
+                   Vector<int>& polarity)
+{
+  if (fin.eof())
+  {
+    return IO_EMPTY;
+  }
+
+  c.resize(N, nEvents);
+  ts.resize(nEvents);
+  polarity.resize(nEvents);
+
+  int n = 0;
+  while (n < nEvents && undistortUnproject<T, N>(lut, fin, c.col(n), ts(n),
+                                                 polarity(n)) == IO_SUCCESS)
+  {
+    ++n;
+  }
+
+  if (n == nEvents)
+  {
+    return IO_SUCCESS;
+  }
+  c.conservativeResize(N, n);
+  ts.conservativeResize(n);
+  polarity.conservativeResize(n);
+  return IO_LESS;
+}
+
+template <typename T, int N>
+IO_STATUS
+undistortUnproject(const UndistortionLUT<T>& lut, const int nEvents,
+                   std::ifstream& fin, EventBlock<T, N>& evs)
+{
+  evs.weights.resize(0);
+  return undistortUnproject<T, N>(lut, nEvents, fin, evs.c, evs.ts,
+                                  evs.polarity);
+}
 }  // namespace EventEMin
 
 #endif  // EVENT_EMIN_EVENT_UNDISTORT_H
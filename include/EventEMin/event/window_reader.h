@@ -0,0 +1,131 @@
+#ifndef EVENT_EMIN_EVENT_WINDOW_READER_H
+#define EVENT_EMIN_EVENT_WINDOW_READER_H
+
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EventEMin/event/io.h"
+#include "EventEMin/event/type.h"
+#include "EventEMin/types_def.h"
+
+namespace EventEMin
+{
+/* reads windows of events on a background thread into a pool of nBuffers
+   windows, so that the next windows are ready when the current one has been
+   processed; the reader blocks while all windows are in use */
+template <typename T, int N>
+class WindowReader
+{
+ public:
+  // fills a window and returns the status of the read
+  typedef std::function<IO_STATUS(EventBlock<T, N>&)> Producer;
+
+ private:
+  Producer producer_;
+
+  std::vector<EventBlock<T, N> > windows_;
+  std::deque<int> free_, ready_;
+  int current_;
+  bool stop_, end_;
+
+  std::mutex mutex_;
+  std::condition_variable freeCond_, readyCond_;
+  std::thread thread_;
+
+ public:
+  WindowReader(const Producer& producer, const int nBuffers = 3)
+      : producer_(producer),
+        windows_(nBuffers),
+        current_(-1),
+        stop_(false),
+        end_(false)
+  {
+    assert(1 < nBuffers);
+    for (int i = 0; i < nBuffers; ++i)
+    {
+      free_.push_back(i);
+    }
+    thread_ = std::thread(&WindowReader::read, this);
+  }
+  WindowReader(const WindowReader&) = delete;
+  WindowReader&
+  operator=(const WindowReader&) = delete;
+  ~WindowReader(void)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    freeCond_.notify_all();
+    thread_.join();
+  }
+
+  /* returns the next complete window, or nullptr at the end of the stream;
+     the window returned by the previous call is given back to the pool */
+  const EventBlock<T, N>*
+  next(void)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (current_ >= 0)
+    {
+      free_.push_back(current_);
+      current_ = -1;
+      freeCond_.notify_one();
+    }
+    readyCond_.wait(lock, [this] { return !ready_.empty() || end_; });
+    if (ready_.empty())
+    {
+      return nullptr;
+    }
+    current_ = ready_.front();
+    ready_.pop_front();
+    return &windows_[current_];
+  }
+
+ private:
+  void
+  read(void)
+  {
+    for (;;)
+    {
+      int i;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        freeCond_.wait(lock, [this] { return !free_.empty() || stop_; });
+        if (stop_)
+        {
+          return;
+        }
+        i = free_.front();
+        free_.pop_front();
+      }
+
+      const IO_STATUS ioStatus = producer_(windows_[i]);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      // incomplete windows end the stream, as in the sequential loaders
+      if (ioStatus == IO_SUCCESS)
+      {
+        ready_.push_back(i);
+      }
+      else
+      {
+        free_.push_back(i);
+        end_ = true;
+      }
+      readyCond_.notify_one();
+      if (end_)
+      {
+        return;
+      }
+    }
+  }
+};
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_EVENT_WINDOW_READER_H
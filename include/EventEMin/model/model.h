@@ -2,8 +2,10 @@
 #define EVENT_EMIN_MODEL_H
 
 #include <Eigen/Geometry>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <type_traits>
 
 #include "EventEMin/types_def.h"
 
@@ -11,6 +13,28 @@ namespace EventEMin
 {
 namespace batch
 {
+// points per call of the vectorised kernels of the warps
+constexpr int forwardChunkSize = 256;
+
+/* whether Func has a vectorised kernel forward(vars, c, ts, tsRef, cm, dcm)
+   of the values and derivatives of the warp, see Model::forward */
+template <typename Func, typename = void>
+struct HasForward : std::false_type
+{
+};
+template <typename Func>
+struct HasForward<
+    Func, std::void_t<decltype(std::declval<const Func&>().forward(
+              std::declval<const typename Func::T*>(),
+              std::declval<const Ref<const Matrix<typename Func::T> >&>(),
+              std::declval<const Ref<const Vector<typename Func::T> >&>(),
+              std::declval<const typename Func::T&>(),
+              std::declval<Ref<RowMajorMatrix<typename Func::T> > >(),
+              std::declval<Ref<RowMajorMatrix<typename Func::T> > >()))> >
+    : std::true_type
+{
+};
+
 template <typename F>
 class Model
 {
@@ -89,6 +113,59 @@ class Model
     }
   }
 
+  /* values cm and derivatives dcm w.r.t. vars of the warped points c, at
+     times ts - tsRef, as planes of contiguous coordinates: row d of cm holds
+     dimension d of the points, and row i * NDims + d of dcm its derivatives
+     w.r.t. variable i; computed by the vectorised kernel of Func on chunks of
+     points if it has one, and point by point with forward derivatives
+     otherwise */
+  void
+  forward(const Vector<T, NVars>& vars, const Ref<const Matrix<T> >& c,
+          const Ref<const Vector<T> >& ts, const T& tsRef,
+          Ref<RowMajorMatrix<T> > cm, Ref<RowMajorMatrix<T> > dcm) const
+  {
+    assert(c.rows() == NDims);
+    assert(cm.rows() == NDims);
+    assert(dcm.rows() == NVars * NDims);
+    assert(c.cols() == ts.size());
+    assert(c.cols() == cm.cols());
+    assert(c.cols() == dcm.cols());
+
+    const int nPoints = c.cols();
+    if constexpr (HasForward<Func>::value)
+    {
+      for (int begin = 0; begin < nPoints; begin += forwardChunkSize)
+      {
+        const int n = std::min(forwardChunkSize, nPoints - begin);
+        func_.forward(vars.data(), c.middleCols(begin, n),
+                      ts.segment(begin, n), tsRef, cm.middleCols(begin, n),
+                      dcm.middleCols(begin, n));
+      }
+    }
+    else
+    {
+      typedef Eigen::AutoDiffScalar<Vector<T, NVars> > ADScalar;
+      Vector<ADScalar, NVars> adVars;
+      for (int i = 0; i < NVars; ++i)
+      {
+        adVars(i) = ADScalar(vars(i), NVars, i);
+      }
+      Vector<ADScalar, NDims> vcm;
+      for (int k = 0; k < nPoints; ++k)
+      {
+        (*this)(adVars, &vcm, c.col(k), ts(k) - tsRef);
+        for (int d = 0; d < NDims; ++d)
+        {
+          cm(d, k) = vcm(d).value();
+          for (int i = 0; i < NVars; ++i)
+          {
+            dcm(i * NDims + d, k) = vcm(d).derivatives()(i);
+          }
+        }
+      }
+    }
+  }
+
   template <typename U>
   void
   operator()(const Vector<U, NVars>& vars, const Ref<const Vector<T> >& c,
@@ -62,6 +62,108 @@ struct Rotation
     chm.noalias() = tMatrix.transpose() * ch;
     cmMap = chm.template head<NDims>() / chm(NDims);
   }
+
+  /* vectorised kernel of the values and derivatives of the warp, see
+     Model::forward: with u = w / |w| and k = [u]x, the homogeneous points
+     are warped to ch - sin(t |w|) k ch + (1 - cos(t |w|)) k^2 ch */
+  void
+  forward(const T* const vars, const Ref<const Matrix<T> >& c,
+          const Ref<const Vector<T> >& ts, const T& tsRef,
+          Ref<RowMajorMatrix<T> > cm, Ref<RowMajorMatrix<T> > dcm) const
+  {
+    typedef Eigen::Array<T, 1, Dynamic, Eigen::RowMajor, 1, forwardChunkSize>
+        ChunkArray;
+    typedef Eigen::Array<T, NMatrix, Dynamic, Eigen::RowMajor, NMatrix,
+                         forwardChunkSize>
+        ChunkPoints;
+
+    const Map<const Vector<T, NW> > w(vars);
+    const int n = c.cols();
+    assert(n <= forwardChunkSize);
+
+    const ChunkArray t(ts.transpose().array() - tsRef);
+    ChunkPoints ch(NMatrix, n), chm(NMatrix, n), dchm(NMatrix, n);
+    ch.template topRows<NDims>() = c.array();
+    ch.row(NDims).setOnes();
+
+    const T wNorm = w.norm();
+    if (T(0.0) < wNorm)
+    {
+      const Vector<T, NW> u(w / wNorm);
+      const Matrix<T, NMatrix, NMatrix> k(skew(u)), k2(k * k);
+      const ChunkArray theta(wNorm * t);
+      const ChunkArray sinTheta(theta.sin()), oneMinusCos(T(1.0) - theta.cos());
+      ChunkPoints kch(NMatrix, n), k2ch(NMatrix, n);
+      kch.matrix().noalias() = k * ch.matrix();
+      k2ch.matrix().noalias() = k2 * ch.matrix();
+      chm = ch - kch.rowwise() * sinTheta + k2ch.rowwise() * oneMinusCos;
+      project(chm, cm);
+
+      ChunkPoints dkch(NMatrix, n), dk2ch(NMatrix, n);
+      for (int i = 0; i < NVars; ++i)
+      {
+        // derivatives of u and of theta w.r.t. w(i)
+        const Vector<T, NW> du((Vector<T, NW>::Unit(i) - u(i) * u) / wNorm);
+        const Matrix<T, NMatrix, NMatrix> dk(skew(du));
+        dkch.matrix().noalias() = dk * ch.matrix();
+        dk2ch.matrix().noalias() = (dk * k + k * dk) * ch.matrix();
+        const ChunkArray dTheta(u(i) * t);
+        dchm = (k2ch.rowwise() * sinTheta - kch.rowwise() * (1 - oneMinusCos))
+                       .rowwise() *
+                   dTheta -
+               dkch.rowwise() * sinTheta + dk2ch.rowwise() * oneMinusCos;
+        projectDerivatives(chm, cm, dchm, dcm.middleRows(i * NDims, NDims));
+      }
+    }
+    else
+    {
+      // no rotation, whose first-order expansion is ch - t [w]x ch
+      chm = ch;
+      project(chm, cm);
+      for (int i = 0; i < NVars; ++i)
+      {
+        dchm.matrix().noalias() =
+            skew(Vector<T, NW>::Unit(i)) * ch.matrix();
+        dchm.rowwise() *= -t;
+        projectDerivatives(chm, cm, dchm, dcm.middleRows(i * NDims, NDims));
+      }
+    }
+  }
+
+ private:
+  static Matrix<T, NMatrix, NMatrix>
+  skew(const Vector<T, NW>& u)
+  {
+    Matrix<T, NMatrix, NMatrix> k;
+    k << T(0.0), -u(2), u(1), u(2), T(0.0), -u(0), -u(1), u(0), T(0.0);
+    return k;
+  }
+
+  // points of the homogeneous points chm, and their derivatives from those of
+  // chm
+  template <typename Derived>
+  static void
+  project(const Eigen::ArrayBase<Derived>& chm, Ref<RowMajorMatrix<T> > cm)
+  {
+    for (int d = 0; d < NDims; ++d)
+    {
+      cm.row(d).array() = chm.row(d) / chm.row(NDims);
+    }
+  }
+  template <typename Derived1, typename Derived2>
+  static void
+  projectDerivatives(const Eigen::ArrayBase<Derived1>& chm,
+                     const Ref<const RowMajorMatrix<T> >& cm,
+                     const Eigen::ArrayBase<Derived2>& dchm,
+                     Ref<RowMajorMatrix<T> > dcm)
+  {
+    for (int d = 0; d < NDims; ++d)
+    {
+      dcm.row(d).array() =
+          (dchm.row(d) - cm.row(d).array() * dchm.row(NDims)) /
+          chm.row(NDims);
+    }
+  }
 };
 }  // namespace batch
 
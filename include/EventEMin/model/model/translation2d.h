@@ -52,6 +52,24 @@ struct Translation2D
     chm.noalias() = tMtx.inverse() * ch;
     cmMap = chm.template head<NDims>() / chm(NDims);
   }
+
+  /* vectorised kernel of the values and derivatives of the warp, see
+     Model::forward: the points are translated to c - t v */
+  void
+  forward(const T* const vars, const Ref<const Matrix<T> >& c,
+          const Ref<const Vector<T> >& ts, const T& tsRef,
+          Ref<RowMajorMatrix<T> > cm, Ref<RowMajorMatrix<T> > dcm) const
+  {
+    const Map<const Vector<T, NV> > v(vars);
+
+    dcm.setZero();
+    for (int d = 0; d < NDims; ++d)
+    {
+      cm.row(d).array() =
+          c.row(d).array() - v(d) * (ts.transpose().array() - tsRef);
+      dcm.row(d * NDims + d).array() = tsRef - ts.transpose().array();
+    }
+  }
 };
 }  // namespace batch
 
@@ -5,6 +5,8 @@
 #include <gsl/gsl_multimin.h>
 
 #include <cassert>
+#include <type_traits>
+#include <utility>
 
 #include "EventEMin/types_def.h"
 
@@ -23,6 +25,22 @@ void
 gslfdffdFunc(const gsl_vector* gvars, void* params, double* gf,
              gsl_vector* gdf);
 
+// whether Func evaluates its gradient through fdf(vars, f, df)
+template <typename Func, typename = void>
+struct HasFdf : std::false_type
+{
+};
+template <typename Func>
+struct HasFdf<Func, std::void_t<decltype(std::declval<const Func&>().fdf(
+                        std::declval<const Vector<typename Func::T,
+                                                  Func::NVars>&>(),
+                        std::declval<Vector<typename Func::T, 1>*>(),
+                        std::declval<Matrix<typename Func::T, 1,
+                                            Func::NVars>*>()))> >
+    : std::true_type
+{
+};
+
 struct GSLfdfOptimiserParams
 {
   const gsl_multimin_fdfminimizer_type* type;
@@ -200,7 +218,7 @@ class GSLfdfOptimiser
     const Map<const Vector<double> > varsMap(gvars->data, NVars);
     const Vector<T, NVars> vars(varsMap.cast<T>());
     Vector<T, 1> f;
-    func_(vars, &f, nullptr);
+    evaluate(vars, &f, nullptr);
     return static_cast<double>(f(0));
   }
 
@@ -212,7 +230,7 @@ class GSLfdfOptimiser
     const Vector<T, NVars> vars(varsMap.cast<T>());
     Vector<T, 1> f;
     Matrix<T, 1, NVars> df;
-    func_(vars, &f, &df);
+    evaluate(vars, &f, &df);
     dfMap = df.template cast<double>();
   }
 
@@ -224,12 +242,27 @@ class GSLfdfOptimiser
     const Vector<T, NVars> vars(varsMap.cast<T>());
     Vector<T, 1> f;
     Matrix<T, 1, NVars> df;
-    func_(vars, &f, &df);
+    evaluate(vars, &f, &df);
     *gf = static_cast<double>(f(0));
     dfMap = df.template cast<double>();
   }
 
  protected:
+  // analytic gradients when Func provides them, automatic ones otherwise
+  void
+  evaluate(const Vector<T, NVars>& vars, Vector<T, 1>* f,
+           Matrix<T, 1, NVars>* df) const
+  {
+    if constexpr (HasFdf<Func>::value)
+    {
+      func_.fdf(vars, f, df);
+    }
+    else
+    {
+      func_(vars, f, df);
+    }
+  }
+
  private:
 };
 
@@ -39,15 +39,17 @@ testBatchExample(const TestBatchParams& testBatchParams)
 
   IO_STATUS ioStatus;
   // read events from file
-  Events<T, NDims> evs;
+  Matrix<T> c;
+  Vector<T> ts;
+  Vector<int> polarity;
   const std::string fevents(testBatchParams.fdir + "/events.txt");
-  ioStatus = load<T, NDims>(fevents, evs);
+  ioStatus = loadParallel<T, NDims>(fevents, c, ts, polarity);
   if (ioStatus != IO_SUCCESS)
   {
     ioStatusMessage(ioStatus, fevents);
     return -1;
   }
-  const int nEvents = evs.size();
+  const int nEvents = ts.size();
   std::cout << "number of events: " << nEvents << '\n';
 
   int width, height;
@@ -60,11 +62,6 @@ testBatchExample(const TestBatchParams& testBatchParams)
     return -1;
   }
 
-  Matrix<T> c;
-  Vector<T> ts;
-  Vector<int> polarity;
-  events2eigen<T>(evs, c, ts, polarity);
-
   // show original events
   showGray(c.template topRows<2>(), polarity, width, height, "Original Events");
   std::cout << "press any key to continue...\n";
@@ -132,15 +129,17 @@ testIncrementalExample(const TestIncrementalParams& testIncrementalParams)
 
   IO_STATUS ioStatus;
   // read events from file
-  Events<T, NDims> evs;
+  Matrix<T> c;
+  Vector<T> ts;
+  Vector<int> polarity;
   const std::string fevents(testIncrementalParams.fdir + "/events.txt");
-  ioStatus = load<T, NDims>(fevents, evs);
+  ioStatus = loadParallel<T, NDims>(fevents, c, ts, polarity);
   if (ioStatus != IO_SUCCESS)
   {
     ioStatusMessage(ioStatus, fevents);
     return -1;
   }
-  const int nEvents = evs.size();
+  const int nEvents = ts.size();
   std::cout << "number of events: " << nEvents << '\n';
 
   int width, height;
@@ -159,11 +158,6 @@ testIncrementalExample(const TestIncrementalParams& testIncrementalParams)
   cv::moveWindow(imgTransformedEvents, 440, 0);
   cv::namedWindow(imgOriginalEvents);
 
-  Matrix<T> c;
-  Vector<T> ts;
-  Vector<int> polarity;
-  events2eigen<T>(evs, c, ts, polarity);
-
   Matrix<T> ct(NDims, nEvents);
   unprojectEvents<T, NDims>()(camParams, c, ct);
 
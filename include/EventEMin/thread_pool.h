@@ -0,0 +1,262 @@
+#ifndef EVENT_EMIN_THREAD_POOL_H
+#define EVENT_EMIN_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace EventEMin
+{
+/* pool of worker threads owned by the library: run executes tasks
+   [0, nTasks) on the workers and the calling thread, and returns once all of
+   them are done; runs requested from within a task, or while another thread
+   is running the pool, execute inline on the calling thread, so that the
+   pool never oversubscribes the cores it was given */
+class ThreadPool
+{
+ private:
+  std::vector<std::thread> workers_;
+
+  // task of the current run, and the next of its indices to be taken
+  const std::function<void(int)>* task_;
+  int nTasks_, nBusy_;
+  std::atomic<int> next_;
+  std::uint64_t nRuns_;
+  bool stop_;
+
+  std::mutex mutex_, runMutex_;
+  std::condition_variable startCond_, doneCond_;
+
+ public:
+  explicit ThreadPool(const int nThreads = defaultNumThreads())
+      : task_(nullptr),
+        nTasks_(0),
+        nBusy_(0),
+        next_(0),
+        nRuns_(0),
+        stop_(false)
+  {
+    startWorkers(nThreads);
+  }
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool&
+  operator=(const ThreadPool&) = delete;
+  ~ThreadPool(void) { stopWorkers(); }
+
+  static int
+  defaultNumThreads(void)
+  {
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+
+  // threads of a run, the calling thread included
+  int
+  nThreads(void) const
+  {
+    return static_cast<int>(workers_.size()) + 1;
+  }
+
+  // waits for the current run, if any, and restarts with nThreads threads
+  void
+  resize(const int nThreads)
+  {
+    const std::lock_guard<std::mutex> run(runMutex_);
+    stopWorkers();
+    startWorkers(nThreads);
+  }
+
+  template <typename F>
+  void
+  run(const int nTasks, const F& f)
+  {
+    if (nTasks <= 0)
+    {
+      return;
+    }
+    std::unique_lock<std::mutex> run(runMutex_, std::defer_lock);
+    if (nTasks == 1 || workers_.empty() || insideTask() || !run.try_lock())
+    {
+      for (int i = 0; i < nTasks; ++i)
+      {
+        f(i);
+      }
+      return;
+    }
+
+    const std::function<void(int)> task(std::cref(f));
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      nTasks_ = nTasks;
+      nBusy_ = static_cast<int>(workers_.size());
+      next_ = 0;
+      ++nRuns_;
+    }
+    startCond_.notify_all();
+    work();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCond_.wait(lock, [this] { return nBusy_ == 0; });
+    task_ = nullptr;
+  }
+
+ private:
+  static bool&
+  insideTask(void)
+  {
+    static thread_local bool inside = false;
+    return inside;
+  }
+
+  void
+  startWorkers(const int nThreads)
+  {
+    assert(0 < nThreads);
+
+    stop_ = false;
+    for (int i = 1; i < nThreads; ++i)
+    {
+      workers_.emplace_back(&ThreadPool::workerLoop, this, nRuns_);
+    }
+  }
+
+  void
+  stopWorkers(void)
+  {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    startCond_.notify_all();
+    for (std::thread& worker : workers_)
+    {
+      worker.join();
+    }
+    workers_.clear();
+  }
+
+  // nRuns: runs started before the worker
+  void
+  workerLoop(std::uint64_t nRuns)
+  {
+    for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        startCond_.wait(lock,
+                        [this, nRuns] { return stop_ || nRuns_ != nRuns; });
+        if (stop_)
+        {
+          return;
+        }
+        nRuns = nRuns_;
+      }
+      work();
+      {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        --nBusy_;
+      }
+      doneCond_.notify_one();
+    }
+  }
+
+  // takes the indices of the current run in order until none is left
+  void
+  work(void)
+  {
+    insideTask() = true;
+    for (int i = next_++; i < nTasks_; i = next_++)
+    {
+      (*task_)(i);
+    }
+    insideTask() = false;
+  }
+};
+
+// pool shared by the batch kernels
+inline ThreadPool&
+threadPool(void)
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+// threads of the batch kernels, 1 to run them on the calling thread only
+inline void
+setNumThreads(const int nThreads)
+{
+  threadPool().resize(nThreads);
+}
+
+inline int
+numThreads(void)
+{
+  return threadPool().nThreads();
+}
+
+/* partitions of the parallel reductions: their number depends on the size of
+   the reduction only, and their partials are reduced in order, so that the
+   results are the same on any number of threads */
+constexpr int maxPartitions = 32;
+
+inline int
+nPartitions(const int n)
+{
+  return std::min(n, maxPartitions);
+}
+
+/* runs f(p) for every partition p of [0, n) on the pool, partition p holding
+   indices p, p + nPartitions(n), ..., which f is expected to visit in order */
+template <typename F>
+void
+parallelPartitions(const int n, const F& f)
+{
+  threadPool().run(nPartitions(n), f);
+}
+
+// sum of the partials of the first nParts partitions, in order, into sum
+template <typename A>
+void
+sumPartitions(const std::vector<A>& partial, const int nParts, A& sum)
+{
+  assert(0 < nParts && nParts <= static_cast<int>(partial.size()));
+
+  sum = partial[0];
+  for (int p = 1; p < nParts; ++p)
+  {
+    sum += partial[p];
+  }
+}
+// sum of the partials of the partitions, in order
+template <typename A>
+A
+sumPartitions(const std::vector<A>& partial)
+{
+  A sum = A();
+  if (!partial.empty())
+  {
+    sumPartitions(partial, static_cast<int>(partial.size()), sum);
+  }
+  return sum;
+}
+
+// runs f(begin, end) on the pool for consecutive blocks of [0, n)
+template <typename F>
+void
+parallelBlocks(const int n, const int blockSize, const F& f)
+{
+  assert(0 < blockSize);
+
+  threadPool().run((n + blockSize - 1) / blockSize, [&](const int b) {
+    f(b * blockSize, std::min(n, (b + 1) * blockSize));
+  });
+}
+}  // namespace EventEMin
+
+#endif  // EVENT_EMIN_THREAD_POOL_H
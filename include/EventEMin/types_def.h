@@ -30,6 +30,9 @@ template <typename T, int Rows>
 using Array = typename Eigen::array<T, Rows>;
 template <typename T, int Rows = Dynamic, int Cols = Dynamic>
 using Matrix = typename Eigen::Matrix<T, Rows, Cols>;
+template <typename T, int Rows = Dynamic, int Cols = Dynamic>
+using RowMajorMatrix =
+    typename Eigen::Matrix<T, Rows, Cols, Eigen::RowMajor>;
 template <typename T, int Cols = Dynamic>
 using RowVector = typename Eigen::Matrix<T, 1, Cols>;
 template <typename T, int rank>
@@ -1,10 +1,31 @@
 #ifndef EVENT_EMIN_UTILITIES_H
 #define EVENT_EMIN_UTILITIES_H
 
+#ifdef __SSE2__
+#include <pmmintrin.h>
+#endif
+
 #include <cmath>
+#include <cstdint>
+
+#include "EventEMin/types_def.h"
 
 namespace EventEMin
 {
+// value of a scalar, without derivatives
+template <typename T>
+const T&
+scalarValue(const T& x)
+{
+  return x;
+}
+template <typename DerType>
+typename Eigen::AutoDiffScalar<DerType>::Scalar
+scalarValue(const Eigen::AutoDiffScalar<DerType>& x)
+{
+  return x.value();
+}
+
 inline double
 computeExp(const double x)
 {
@@ -27,6 +48,96 @@ computeExp(const double x)
 #endif
 }
 
+// type in which many terms of type T are summed
+template <typename T>
+struct Accumulator
+{
+  typedef T type;
+};
+template <>
+struct Accumulator<float>
+{
+  typedef double type;
+};
+
+/* Neumaier's compensated sum, whose rounding error does not grow with the
+   number of terms */
+template <typename U>
+class CompensatedSum
+{
+ private:
+  U sum_, compensation_;
+
+ public:
+  CompensatedSum(void) : sum_(0.0), compensation_(0.0) {}
+
+  U
+  value(void) const
+  {
+    return sum_ + compensation_;
+  }
+
+  CompensatedSum&
+  operator+=(const U& x)
+  {
+    using std::abs;
+    const U t = sum_ + x;
+    if (abs(scalarValue(sum_)) >= abs(scalarValue(x)))
+    {
+      compensation_ += (sum_ - t) + x;
+    }
+    else
+    {
+      compensation_ += (x - t) + sum_;
+    }
+    sum_ = t;
+    return *this;
+  }
+  CompensatedSum&
+  operator+=(const CompensatedSum& s)
+  {
+    *this += s.sum_;
+    compensation_ += s.compensation_;
+    return *this;
+  }
+};
+
+/* flushes denormal operands and results to zero in the calling thread while
+   in scope, since they take a much slower path than normal numbers; exp of
+   the exponents of distant points underflows into them */
+class FlushDenormals
+{
+ private:
+#ifdef __SSE2__
+  const unsigned int csr_;
+#endif
+
+ public:
+#ifdef __SSE2__
+  FlushDenormals(void) : csr_(_mm_getcsr())
+  {
+    _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+  }
+  ~FlushDenormals(void) { _mm_setcsr(csr_); }
+#else
+  FlushDenormals(void) {}
+#endif
+  FlushDenormals(const FlushDenormals&) = delete;
+  FlushDenormals&
+  operator=(const FlushDenormals&) = delete;
+};
+
+// splitmix64 hash, which turns a counter into a pseudo-random number
+inline std::uint64_t
+splitMix64(std::uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
 // add modulus (cyclic)
 inline int
 addCyclic(const int x, const int a, const int n)
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <string>
+
+#include "EventEMin.h"
+
+using namespace EventEMin;
+
+template <int N>
+int
+convert(const std::string& fdir)
+{
+  typedef float T;
+
+  int width, height;
+  Matrix<T, 3, 3> camParams;
+  const std::string fcalib(fdir + "/calib.txt");
+  IO_STATUS ioStatus = loadCamParams<T>(fcalib, width, height, camParams);
+  if (ioStatus != IO_SUCCESS)
+  {
+    ioStatusMessage(ioStatus, fcalib);
+    return -1;
+  }
+
+  const std::string fevents(fdir + "/events.txt"),
+      fbinary(fdir + "/events.bin");
+  ioStatus = text2binary<T, N>(fevents, fbinary, width, height);
+  if (ioStatus != IO_SUCCESS)
+  {
+    ioStatusMessage(ioStatus, fevents);
+    return -1;
+  }
+
+  // check the converted file
+  MappedEvents<T, N> mevs;
+  ioStatus = mevs.open(fbinary);
+  ioStatusMessage(ioStatus, fbinary);
+  if (ioStatus != IO_SUCCESS)
+  {
+    return -1;
+  }
+  std::cout << "number of events: " << mevs.nEvents() << ", ts: ["
+            << mevs.ts(0) << ", " << mevs.ts(mevs.nEvents() - 1) << "]\n";
+
+  return 0;
+}
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cout << "usage: " << argv[0] << " [events dir] [number of dims]\n";
+    return -1;
+  }
+
+  const int nDims = argc < 3 ? 2 : std::atoi(argv[2]);
+  switch (nDims)
+  {
+    case 2:
+      return convert<2>(argv[1]);
+    case 3:
+      return convert<3>(argv[1]);
+    default:
+      std::cerr << "number of dims must be 2 or 3\n";
+      return -1;
+  }
+}
@@ -29,7 +29,7 @@ main(int argc, char* argv[])
   // typedef IncrementalTranslation2D<T> Model;
   // typedef IncrementalTranslationNormal<T> Model;
 
-  constexpr int NDims = Model::NDims;
+  constexpr int NDims = Model::NDims, NVars = Model::NVars;
 
   /* you can modify the dispersion measure used by uncommenting the
    corresponding line */
@@ -52,8 +52,8 @@ main(int argc, char* argv[])
   // write estimates to file
   const std::string festimates(std::string(argv[3]) + "/" +
                                std::string(argv[4]) + "_estimates.txt");
-  std::ofstream fout(festimates.c_str());
-  if (!fout.is_open())
+  EstimateSink<T, NVars> sink(festimates);
+  if (!sink.isOpen())
   {
     std::cerr << "error writing estimates to file " << festimates << '\n';
     return -1;
@@ -75,6 +75,8 @@ main(int argc, char* argv[])
   cv::cv2eigen(camParamsCV, camParams);
   cv::Mat undistortionMap;
   initUndistort<T>(width, height, camParamsCV, distCoeffs, undistortionMap);
+  // raw pixels to undistorted and unprojected coordinates
+  const UndistortionLUT<T> lut(0, width, 0, height, undistortionMap, camParams);
 
   const Vector<T, NDims> scale(Vector<T, NDims>::Ones());
 
@@ -90,23 +92,21 @@ main(int argc, char* argv[])
                         Dispersion::Params(minStep, maxIter, wSize), nEvents,
                         {width, height});
 
-  Vector<T, NDims> c, ct;
+  Vector<T, NDims> ct;
   T ts;
   int polarity;
 
-  for (int k = 0; undistort<T, NDims>(0, width, 0, height, undistortionMap, fin,
-                                      c, ts, polarity) == IO_SUCCESS;
+  for (int k = 0; undistortUnproject<T, NDims>(lut, fin, ct, ts, polarity) ==
+                  IO_SUCCESS;
        ++k)
   {
-    unprojectEvent<T, NDims>()(camParams, c, ct);
-
     dispersion.run(ct, ts);
 
     if ((k + 1) % nEvents == 0)
     {
       std::cout << "ts: " << ts << ", vars: " << dispersion.vars().transpose()
                 << '\n';
-      fout << ts << ' ' << dispersion.vars().transpose() << std::endl;
+      sink.push(ts, dispersion.vars());
     }
   }
 
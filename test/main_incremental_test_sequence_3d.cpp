@@ -26,7 +26,7 @@ main(int argc, char* argv[])
   typedef IncrementalSixDOF<T> Model;
   // typedef IncrementalTranslation3D<T> Model;
 
-  constexpr int NDims = Model::NDims;
+  constexpr int NDims = Model::NDims, NVars = Model::NVars;
 
   /* you can modify the dispersion measure used by uncommenting the
    corresponding line */
@@ -47,8 +47,8 @@ main(int argc, char* argv[])
   // write estimates to file
   const std::string festimates(std::string(argv[5]) + "/" +
                                std::string(argv[6]) + "_estimates.txt");
-  std::ofstream fout(festimates.c_str());
-  if (!fout.is_open())
+  EstimateSink<T, NVars> sink(festimates);
+  if (!sink.isOpen())
   {
     std::cerr << "error writing estimates to file " << festimates << '\n';
     return -1;
@@ -102,7 +102,7 @@ main(int argc, char* argv[])
     {
       std::cout << "ts: " << ts << ", vars: " << dispersion.vars().transpose()
                 << '\n';
-      fout << ts << ' ' << dispersion.vars().transpose() << std::endl;
+      sink.push(ts, dispersion.vars());
     }
   }
 
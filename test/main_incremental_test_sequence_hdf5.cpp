@@ -0,0 +1,113 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "EventEMin.h"
+
+using namespace EventEMin;
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 5)
+  {
+    std::cout << "usage: " << argv[0]
+              << " [events dir] [number of events] "
+                 "[saving dir] [file name]\n";
+    return -1;
+  }
+
+  typedef float T;
+
+  /* you can modify the model used by uncommenting the corresponding line */
+
+  // model
+  // typedef IncrementalAffinity<T> Model;
+  // typedef IncrementalIsometry<T> Model;
+  typedef IncrementalRotation<T> Model;
+  // typedef IncrementalSimilarity<T> Model;
+  // typedef IncrementalTranslation2D<T> Model;
+  // typedef IncrementalTranslationNormal<T> Model;
+
+  constexpr int NDims = Model::NDims, NVars = Model::NVars;
+
+  /* you can modify the dispersion measure used by uncommenting the
+   corresponding line */
+
+  // incremental measures
+  typedef IncrementalPotential<Model> Dispersion;
+  // typedef IncrementalTsallis<Model> Dispersion;
+  // typedef IncrementalPotentialWhiten<Model> Dispersion;
+  // typedef IncrementalTsallisWhiten<Model> Dispersion;
+
+  // read distorted events from file
+  const std::string fevents(std::string(argv[1]) + "/events.h5");
+  Hdf5Reader<T> events;
+  if (events.open(fevents) != IO_SUCCESS)
+  {
+    std::cerr << "error reading events from file " << fevents << '\n';
+    return -1;
+  }
+
+  // write estimates to file
+  const std::string festimates(std::string(argv[3]) + "/" +
+                               std::string(argv[4]) + "_estimates.txt");
+  EstimateSink<T, NVars> sink(festimates);
+  if (!sink.isOpen())
+  {
+    std::cerr << "error writing estimates to file " << festimates << '\n';
+    return -1;
+  }
+
+  int width, height;
+  cv::Mat camParamsCV, distCoeffs;
+  const std::string fcalib(std::string(argv[1]) + "/calib.txt");
+  const IO_STATUS ioStatus =
+      loadCamParams<T>(fcalib, width, height, camParamsCV, distCoeffs);
+  if (ioStatus != IO_SUCCESS)
+  {
+    ioStatusMessage(ioStatus, fcalib);
+    return -1;
+  }
+
+  // initialise grid-based undistortion map
+  Matrix<T, 3, 3> camParams;
+  cv::cv2eigen(camParamsCV, camParams);
+  cv::Mat undistortionMap;
+  initUndistort<T>(width, height, camParamsCV, distCoeffs, undistortionMap);
+  // raw pixels to undistorted and unprojected coordinates
+  const UndistortionLUT<T> lut(0, width, 0, height, undistortionMap, camParams);
+
+  const Vector<T, NDims> scale(Vector<T, NDims>::Ones());
+
+  // tolerance that indicates a minimum has been reached
+  const T minStep = T(1.0e-6);
+  // maximum iterations
+  const int maxIter = 10;
+  // neighbouring radius
+  const int wSize = 4;
+  // number of events to maintain
+  const int nEvents = std::atoi(argv[2]);
+  Dispersion dispersion(camParams, scale,
+                        Dispersion::Params(minStep, maxIter, wSize), nEvents,
+                        {width, height});
+
+  // the events are run in blocks of nEvents, read one chunk at a time
+  EventBlock<T, NDims> evs;
+  while (events.read(nEvents, evs) == IO_SUCCESS)
+  {
+    undistortUnproject<T, NDims>(lut, evs);
+    if (evs.empty())
+    {
+      continue;
+    }
+    dispersion.run(evs);
+
+    const T ts = evs.ts(evs.nEvents() - 1);
+    std::cout << "ts: " << ts << ", vars: " << dispersion.vars().transpose()
+              << '\n';
+    sink.push(ts, dispersion.vars());
+  }
+
+  return 0;
+}
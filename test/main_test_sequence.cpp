@@ -64,8 +64,8 @@ main(int argc, char* argv[])
   // write estimates to file
   const std::string festimates(std::string(argv[3]) + "/" +
                                std::string(argv[4]) + "_estimates.txt");
-  std::ofstream fout(festimates.c_str());
-  if (!fout.is_open())
+  EstimateSink<T, NVars> sink(festimates);
+  if (!sink.isOpen())
   {
     std::cerr << "error writing estimates to file " << festimates << '\n';
     return -1;
@@ -87,6 +87,8 @@ main(int argc, char* argv[])
   cv::cv2eigen(camParamsCV, camParams);
   cv::Mat undistortionMap;
   initUndistort<T>(width, height, camParamsCV, distCoeffs, undistortionMap);
+  // raw pixels to undistorted and unprojected coordinates
+  const UndistortionLUT<T> lut(0, width, 0, height, undistortionMap, camParams);
 
   Dispersion dispersion(width);
 
@@ -105,16 +107,14 @@ main(int argc, char* argv[])
   // apply whitening pre-processing step
   const bool whiten = false;
 
+  // the next windows are read while the current one is optimised
   const int nEvents = std::atoi(argv[2]);
-  Matrix<T> c;
-  Vector<T> ts;
-  Vector<int> polarity;
-  while (undistort<T, NDims>(0, width, 0, height, undistortionMap, nEvents, fin,
-                             c, ts, polarity) == IO_SUCCESS)
+  WindowReader<T, NDims> reader([&](EventBlock<T, NDims>& evs) {
+    return undistortUnproject<T, NDims>(lut, nEvents, fin, evs);
+  });
+  while (const EventBlock<T, NDims>* evs = reader.next())
   {
-    Matrix<T> ct(NDims, c.cols());
-    unprojectEvents<T, NDims>()(camParams, c, ct);
-    dispersion.assignPoints(ct, ts, polarity, whiten);
+    dispersion.assignPoints(*evs, whiten);
 
     // optimise
     Optimiser optimiser(
@@ -126,7 +126,7 @@ main(int argc, char* argv[])
     vars = optimiser.vars();
     std::cout << "ts: " << dispersion.tsEnd() << ", vars: " << vars.transpose()
               << '\n';
-    fout << dispersion.tsEnd() << ' ' << vars.transpose() << std::endl;
+    sink.push(dispersion.tsEnd(), vars);
   }
 
   return 0;
@@ -56,8 +56,8 @@ main(int argc, char* argv[])
   // write estimates to file
   const std::string festimates(std::string(argv[5]) + "/" +
                                std::string(argv[6]) + "_estimates.txt");
-  std::ofstream fout(festimates.c_str());
-  if (!fout.is_open())
+  EstimateSink<T, NVars> sink(festimates);
+  if (!sink.isOpen())
   {
     std::cerr << "error writing estimates to file " << festimates << '\n';
     return -1;
@@ -90,16 +90,21 @@ main(int argc, char* argv[])
   // apply whitening pre-processing step
   const bool whiten = false;
 
+  // the next windows are read while the current one is optimised
   const int nEvents = std::atoi(argv[2]);
-  Matrix<T> c;
-  Vector<T> ts;
-  Vector<int> polarity;
-  while (loadDepthThresh<T>(nEvents, std::atof(argv[3]), std::atof(argv[4]),
-                            fin, c, ts, polarity) == IO_SUCCESS)
+  const T depthMin = std::atof(argv[3]), depthMax = std::atof(argv[4]);
+  WindowReader<T, NDims> reader([&](EventBlock<T, NDims>& evs) {
+    const IO_STATUS ioStatus =
+        loadDepthThresh<T>(nEvents, depthMin, depthMax, fin, evs);
+    if (ioStatus == IO_SUCCESS)
+    {
+      unprojectEvents<T, NDims>()(camParams, evs.c);
+    }
+    return ioStatus;
+  });
+  while (const EventBlock<T, NDims>* evs = reader.next())
   {
-    Matrix<T> ct(NDims, c.cols());
-    unprojectEvents<T, NDims>()(camParams, c, ct);
-    dispersion.assignPoints(ct, ts, polarity, whiten);
+    dispersion.assignPoints(*evs, whiten);
 
     Optimiser optimiser(
         dispersion,
@@ -110,7 +115,7 @@ main(int argc, char* argv[])
     vars = optimiser.vars();
     std::cout << "ts: " << dispersion.tsEnd() << ", vars: " << vars.transpose()
               << '\n';
-    fout << dispersion.tsEnd() << ' ' << vars.transpose() << std::endl;
+    sink.push(dispersion.tsEnd(), vars);
   }
 
   return 0;